@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "gbafe.h"
+#include "CTF.h"
+
+/*
+ * Renders every chapter title in `HostFont.c` some number of
+ * times and reports how long it took.
+ *
+ * Usage: Benchmark <rounds> [<strips> [<stats> [<method>]]]
+ *
+ * If `<strips>` is given, each title's strip is written to
+ * it in title order, 0x800 bytes of 4bpp tiles per title, so
+ * that they can be compared against golden strips.
+ *
+ * If `<stats>` is given, the number of glyphs, font pages,
+ * decompressions, and uploads for each title are written to it
+ * as tab-separated values. Use `-` to skip writing them.
+ *
+ * `<method>` is how the titles are drawn:
+ *   load    `LoadChapterTitleGfx`, the default
+ *   batch   `LoadChapterTitleGfxBatch`, a batch at a time
+ *   <n>     `ContinueChapterTitleRender`, `<n>` glyphs per call
+ *
+ * Batches are drawn to a strip's worth of tiles each, and their
+ * decompressions and uploads are counted for their first title.
+ */
+
+#define HOST_METHOD_LOAD 0
+#define HOST_METHOD_BATCH (-1)
+
+#define HOST_STRIP_TILES (CHAPTER_TITLE_STRIP_SIZE / TILE_SIZE_4BPP)
+
+static struct ChapterTitleRender sHostRender;
+
+static u32 CountBits(u32 value) {
+  u32 count = 0;
+
+  for (; value != 0; value &= (value - 1))
+    count++;
+
+  return count;
+}
+
+static int RenderChapterTitles(unsigned titleID, int method) {
+  /*
+   * Draws the title, or the batch of titles starting at
+   * it, using a method. Returns the number of titles drawn.
+   * The `n`th title of a batch is drawn to the `n`th strip
+   * of tiles, and other titles are drawn to the first.
+   */
+
+  struct ChapterTitleRender* render;
+  int vramTiles[CHAPTER_TITLE_BATCH_SIZE];
+  unsigned titleIDs[CHAPTER_TITLE_BATCH_SIZE];
+  int count;
+
+  if (method == HOST_METHOD_LOAD) {
+    LoadChapterTitleGfx(0, titleID);
+    return 1;
+  }
+
+  if (method == HOST_METHOD_BATCH) {
+
+    for (count = 0; (count < CHAPTER_TITLE_BATCH_SIZE) && (titleID < gChapterTitleEntryCount); count++, titleID++) {
+      vramTiles[count] = count * HOST_STRIP_TILES;
+      titleIDs[count] = titleID;
+    }
+
+    LoadChapterTitleGfxBatch(vramTiles, titleIDs, count);
+    return count;
+  }
+
+  render = (gChapterTitleRenders != NULL) ? gChapterTitleRenders : &sHostRender;
+
+  StartChapterTitleRender(render, VRAM, gChapterTitleScratch, titleID);
+
+  while (!ContinueChapterTitleRender(render, method))
+    ;
+
+  return 1;
+}
+
+static int WriteChapterTitleStrips(const char* stripsName, const char* statsName, int method) {
+  /*
+   * Renders each title once, writing its strip and how
+   * much work it took. Returns nonzero if a file couldn't
+   * be written.
+   *
+   * Titles are drawn a second time before their strips are
+   * read back, which is when the VRAM cache, if there is one,
+   * finds them already drawn.
+   */
+
+  unsigned titleID;
+  int decompressCount;
+  int uploadCount;
+  int count;
+  int i;
+  FILE* strips = NULL;
+  FILE* stats = NULL;
+  struct ChapterTitleLayout layout;
+
+  if ((stripsName != NULL) && ((strips = fopen(stripsName, "wb")) == NULL)) {
+    perror(stripsName);
+    return 1;
+  }
+
+  if ((statsName != NULL) && ((stats = fopen(statsName, "w")) == NULL)) {
+    perror(statsName);
+    if (strips != NULL)
+      fclose(strips);
+    return 1;
+  }
+
+  if (stats != NULL)
+    fprintf(stats, "Title\tGlyphs\tPages\tDecompressions\tUploads\n");
+
+  for (titleID = 0; titleID < gChapterTitleEntryCount; titleID += count) {
+
+    decompressCount = gHostDecompressCount;
+    uploadCount = gHostUploadCount;
+
+    count = RenderChapterTitles(titleID, method);
+
+    decompressCount = gHostDecompressCount - decompressCount;
+    uploadCount = gHostUploadCount - uploadCount;
+
+    RenderChapterTitles(titleID, method);
+
+    for (i = 0; i < count; i++) {
+
+      if (strips != NULL)
+        fwrite(VRAM + (i * CHAPTER_TITLE_STRIP_SIZE), 1, CHAPTER_TITLE_STRIP_SIZE, strips);
+
+      if (stats != NULL) {
+
+        LayoutChapterTitle(GetChapterTitle(titleID + i), &layout);
+
+        fprintf(stats, "%u\t%d\t%u\t%d\t%d\n",
+          titleID + i,
+          layout.count,
+          CountBits(GetChapterTitleLayoutPages(&layout)),
+          (i == 0) ? decompressCount : 0,
+          (i == 0) ? uploadCount : 0);
+      }
+    }
+  }
+
+  if (strips != NULL)
+    fclose(strips);
+
+  if (stats != NULL)
+    fclose(stats);
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+
+  int rounds;
+  int round;
+  int method;
+  unsigned titleID;
+  long glyphs;
+  int decompressCount;
+  clock_t start;
+  double seconds;
+  struct ChapterTitleLayout layout;
+
+  rounds = (argc > 1) ? atoi(argv[1]) : 1;
+
+  method = HOST_METHOD_LOAD;
+
+  if (argc > 4) {
+
+    if (strcmp(argv[4], "batch") == 0) {
+
+      method = HOST_METHOD_BATCH;
+
+    } else if (strcmp(argv[4], "load") != 0) {
+
+      method = atoi(argv[4]);
+
+      if (method <= 0) {
+        fprintf(stderr, "Unknown method %s\n", argv[4]);
+        return 1;
+      }
+    }
+  }
+
+  if (argc > 2) {
+    if (WriteChapterTitleStrips(argv[2], ((argc > 3) && (strcmp(argv[3], "-") != 0)) ? argv[3] : NULL, method) != 0)
+      return 1;
+  }
+
+  glyphs = 0;
+  for (titleID = 0; titleID < gChapterTitleEntryCount; titleID++) {
+    LayoutChapterTitle(GetChapterTitle(titleID), &layout);
+    glyphs += layout.count;
+  }
+
+  decompressCount = gHostDecompressCount;
+
+  start = clock();
+
+  for (round = 0; round < rounds; round++) {
+    for (titleID = 0; titleID < gChapterTitleEntryCount; )
+      titleID += RenderChapterTitles(titleID, method);
+  }
+
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  if (rounds == 0)
+    return 0;
+
+  printf("Rendered %d titles (%ld glyphs) %d times in %.3f seconds\n",
+    gChapterTitleEntryCount, glyphs, rounds, seconds);
+  printf("  %.0f titles per second, %.0f glyphs per second\n",
+    (gChapterTitleEntryCount * (double)rounds) / seconds,
+    (glyphs * (double)rounds) / seconds);
+  printf("  %d font page decompressions\n", gHostDecompressCount - decompressCount);
+
+  return 0;
+}
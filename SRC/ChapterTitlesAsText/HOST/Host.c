@@ -0,0 +1,74 @@
+
+#include "gbafe.h"
+#include "CTF.h"
+
+/*
+ * This lets the chapter title code run on a PC, so that it can be
+ * benchmarked without an emulator. The font and chapter titles
+ * come from `HostFont.c`, which is written by the
+ * `benchmark_chapter_titles.py` script.
+ *
+ * Compressed data is replaced by uncompressed data with its
+ * size in bytes in the first word, since the host doesn't have
+ * the BIOS's decompression routines.
+ */
+
+u8 gHostVRAM[0x18000];
+u8 gGenericBuffer[0x2000];
+
+struct GMapData gGMData;
+
+__typeof__(gChapterTitleTileInfo) gChapterTitleTileInfo;
+
+struct ChapterTitlePalette gChapterTitleCardPalettes[6];
+
+u8 gWMMonsterSpawnLocations[1];
+u8 gWMMonsterSpawnsSize;
+
+int gHostDecompressCount;
+int gHostUploadCount;
+
+extern char* gHostTitleText[];
+
+void CpuFastFill(u32 value, void* dest, u32 size) {
+  u32* destWords = dest;
+  u32 i;
+
+  for (i = 0; i < (size / 4); i++)
+    destWords[i] = value;
+}
+
+void CpuFastCopy(const void* src, void* dest, u32 size) {
+  memcpy(dest, src, size);
+}
+
+void RegisterTileGraphics(const void* src, void* dest, unsigned size) {
+  gHostUploadCount++;
+  memcpy(dest, src, size);
+}
+
+void Decompress(const void* src, void* dest) {
+  const u32* srcWords = src;
+
+  gHostDecompressCount++;
+  memcpy(dest, &srcWords[1], srcWords[0]);
+}
+
+char* GetStringFromIndex(int index) {
+  return gHostTitleText[index];
+}
+
+void ApplyPalette(const void* palette, int paletteID) {
+}
+
+const struct ROMChapterData* GetChapterDefinition(unsigned chIndex) {
+  return NULL;
+}
+
+int GetWMChapterID(int chapterID) {
+  return 0;
+}
+
+int GetNextWMLocation(struct GMapData* data) {
+  return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef GUARD_HOST_GBAFE_H
+#define GUARD_HOST_GBAFE_H
+
+/*
+ * This stands in for CLib's `gbafe.h` when building the
+ * chapter title code for a PC, see `Host.c`. Only the parts
+ * of CLib that the chapter title code uses are here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+
+#define ABS(aValue) ((aValue) >= 0 ? (aValue) : -(aValue))
+
+extern u8 gHostVRAM[0x18000];
+extern u8 gGenericBuffer[0x2000];
+
+#define VRAM (gHostVRAM)
+
+struct ChapterState {
+
+  u8 chapterIndex;
+  u8 chapterStateBits;
+
+};
+
+struct GMapData {
+
+  int unk00;
+
+};
+
+struct ROMChapterData;
+
+extern struct GMapData gGMData;
+
+extern int gHostDecompressCount;
+extern int gHostUploadCount;
+
+void CpuFastFill(u32 value, void* dest, u32 size);
+void CpuFastCopy(const void* src, void* dest, u32 size);
+void RegisterTileGraphics(const void* src, void* dest, unsigned size);
+void Decompress(const void* src, void* dest);
+char* GetStringFromIndex(int index);
+void ApplyPalette(const void* palette, int paletteID);
+
+#endif // GUARD_HOST_GBAFE_H
@@ -7,9 +7,25 @@ typedef u8  bool8;
 typedef u16 bool16;
 typedef u32 bool32;
 
+#ifndef TRUE
+  #define TRUE 1
+  #define FALSE 0
+#endif // TRUE
+
 #define CHAPTER_TITLE_WIDTH 192 // In pixels
+#define CHAPTER_TITLE_HEIGHT 16 // In pixels
 #define TILE_SIZE_4BPP 32 // In bytes
 
+#define CHAPTER_TITLE_MAX_GLYPHS 64
+#define CHAPTER_TITLE_BATCH_SIZE 3 // Titles drawn at once by `LoadChapterTitleGfxBatch`, and render states in `gChapterTitleRenders`
+#define CHAPTER_TITLE_STRIP_COLUMNS 32 // In tiles
+#define CHAPTER_TITLE_STRIP_SIZE (CHAPTER_TITLE_STRIP_COLUMNS * 2 * TILE_SIZE_4BPP) // In bytes
+
+#define CTF_PAGE_SIZE (256 * TILE_SIZE_4BPP) // In bytes
+#define CTF_MAX_PAGES 16
+
+#define UTF8_REPLACEMENT_CHARACTER 0xFFFD
+
 // I'm using the same value to terminate each list.
 #define TERMINATOR (-1)
 
@@ -201,33 +217,6 @@ extern u8 gWMMonsterSpawnsSize; // FE8U 0x08206951
 
 // These are the structs for our custom font.
 
- struct KernRightCharacter {
-  /*
-   * This is the right-side character in a
-   * pair to be kerned or a terminator.
-   */
-
-  union {
-
-    struct {
-
-      u32 codepoint : 24; /*
-        * The unicode codepoint of the character.
-        */
-      s8 leftAdjust : 8; /*
-        * The number of pixels to adjust the right
-        * character by. A negative number moves it
-        * closer to the left character.
-        */
-
-    };
-
-    s32 terminator;
-
-    };
-
-};
-
 struct FontEntry {
   /*
    * This is the main data struct for glyphs in the font.
@@ -261,35 +250,19 @@ struct FontEntry {
       u8 tile; /*
         * The tile of the glyph within the font page.
         */
-      const struct KernRightCharacter* matchList; /*
-        * This is a pointer to a list of info that
-        * is used to check if we can kern with a character
-        * to the right and by how much.
+      u8 leftKerningClass; /*
+        * The glyph's row in the kerning matrix when
+        * it's the left character of a pair.
         */
-
-    };
-
-    s32 terminator;
-
-  };
-
-};
-
-struct WhitespaceEntry {
-  /*
-   * This struct is used to mark characters
-   * that are purely whitespace.
-   */
-
-  union {
-
-    struct {
-
-      u32 codepoint : 24; /*
-        * This is the character's unicode codepoint.
+      u8 rightKerningClass; /*
+        * The glyph's column in the kerning matrix when
+        * it's the right character of a pair.
         */
-      u8 width; /*
-        * This is the width of the character in pixels.
+      u16 composite; /*
+        * When nonzero, the glyph is drawn using other glyphs
+        * and this is the index of its first part in
+        * `gCTFCompositeParts`. Composite glyphs don't
+        * have any graphics of their own.
         */
 
     };
@@ -297,6 +270,7 @@ struct WhitespaceEntry {
     s32 terminator;
 
   };
+
 };
 
 struct ChapterTitleEntry {
@@ -313,32 +287,236 @@ struct ChapterTitleEntry {
   };
 };
 
-struct ChapterTitleFontLookupEntry {
+/*
+ * The font's index maps codepoints to glyphs. It's split into
+ * blocks of `CTF_INDEX_BLOCK_SIZE` codepoints: `gCTFIndexBlocks`
+ * has an entry for each block up to the font's highest codepoint,
+ * which is either `CTF_INDEX_MISSING` or the block's number within
+ * `gCTFIndex`. Each entry in a block is a glyph's index into
+ * `gCTFMetadata`, `CTF_INDEX_WHITESPACE | width` for whitespace
+ * characters, or `CTF_INDEX_MISSING`.
+ */
+
+#define CTF_INDEX_BLOCK_SHIFT 8
+#define CTF_INDEX_BLOCK_SIZE (1 << CTF_INDEX_BLOCK_SHIFT)
+
+#define CTF_INDEX_MISSING 0xFFFF
+#define CTF_INDEX_WHITESPACE 0x8000
+
+struct ChapterTitleGlyphPart {
   /*
-   * Instead of trawling through the entire font metadata
-   * table to find a character, we slice up the table into
-   * chunks. We find the chunk with the highest starting
-   * codepoint that is still less than or equal to the
-   * target codepoint and start looking there.
+   * One of the glyphs that make up a composite glyph,
+   * such as a base letter or an accent mark. Each composite
+   * glyph's parts end with a part whose `glyph` is
+   * `CTF_INDEX_MISSING`.
    */
 
-  union {
+  u16 glyph; /*
+    * The part's index in `gCTFMetadata`. Parts are
+    * never composite glyphs themselves.
+    */
+  s8 x; /*
+    * The part's offset in pixels from the
+    * composite glyph's position.
+    */
+  s8 y;
 
-    struct {
+};
 
-      u32 codepoint; /*
-        * This is the first codepoint in the block.
-        */
-      u32 index; /*
-        * This is the codepoint's index into the
-        * metadata table.
-        */
+struct ChapterTitleStream {
+  /*
+   * A special chapter title that was laid out when
+   * building, see `render_chapter_titles.py`.
+   */
 
-    };
+  u16 count; /*
+    * The number of glyphs in the title.
+    */
+  s16 padding; /*
+    * The number of pixels to indent the title by.
+    */
+  u8 glyphs[]; /*
+    * Three bytes for each glyph: its index in `gCTFMetadata`
+    * as a little endian short, followed by its distance in
+    * pixels from the previous glyph.
+    */
 
-    s32 terminator;
+};
+
+struct UTF8Iterator {
+  /*
+   * The state of a pass over a UTF-8 encoded
+   * string, see `NextUTF8Character`.
+   */
+
+  const u8* text; /*
+    * The next byte to read.
+    */
+  u32 asciiRun; /*
+    * ASCII characters that have already been read
+    * but not handed out yet, lowest byte first.
+    */
+  int asciiCount; /*
+    * The number of characters in `asciiRun`.
+    */
+
+};
+
+struct ChapterTitleGlyph {
+  /*
+   * A single glyph in a laid-out chapter title.
+   */
+
+  const struct FontEntry* fontCharacter;
+  s16 x; /*
+    * The glyph's position in pixels, relative
+    * to the start of the chapter title.
+    */
+  s16 y; /*
+    * The glyph's vertical offset in pixels. This
+    * is only nonzero for parts of composite glyphs.
+    */
+
+};
+
+struct ChapterTitleLayout {
+  /*
+   * A chapter title's glyphs and their positions, so
+   * that the title's text only needs to be read once.
+   */
+
+  int count; /*
+    * The number of glyphs in the title. Composite glyphs
+    * are split into their parts, which each count
+    * as a glyph.
+    */
+  int width; /*
+    * The width of the whole title in pixels.
+    */
+  struct ChapterTitleGlyph glyphs[CHAPTER_TITLE_MAX_GLYPHS];
+
+};
+
+struct ChapterTitleRender {
+  /*
+   * The state of an incremental chapter title render,
+   * see `StartChapterTitleRender`. This is owned by
+   * whoever is doing the rendering and has to stay
+   * alive until the render has finished.
+   */
+
+  u32* dest; /*
+    * Where the chapter title ends up in VRAM.
+    */
+  u32* surface; /*
+    * Where glyphs are being drawn. This is either
+    * `dest` or a scratch surface that gets uploaded
+    * to `dest` when the title is finished.
+    */
+  bool queueUpload; /*
+    * When set, the scratch surface is uploaded during
+    * the next VBlank instead of immediately.
+    */
+  const u8* strip; /*
+    * The title's pre-rendered strip, or NULL if the
+    * title is being drawn glyph-by-glyph.
+    */
+  int padding; /*
+    * The number of pixels to indent the title by.
+    */
+  u32 pendingPages; /*
+    * A bitfield of font pages that still have
+    * glyphs left to draw.
+    */
+  int page; /*
+    * The font page that is currently being drawn.
+    */
+  int nextGlyph; /*
+    * The index of the next glyph in the layout to
+    * check when resuming the current page.
+    */
+  struct ChapterTitleLayout layout;
+
+};
+
+struct ChapterTitleFontPageCache {
+  /*
+   * This lives at the start of the font page cache's
+   * space in EWRAM, and is followed by a buffer for each
+   * of the cache's slots.
+   */
+
+  u32 magic; /*
+    * This is set to `CTF_PAGE_CACHE_MAGIC` once the cache
+    * has been initialized, so that we don't trust whatever
+    * garbage was in RAM before.
+    */
+  u32 hits; /*
+    * The number of times that a requested page was
+    * already decompressed.
+    */
+  u32 misses; /*
+    * The number of times that a requested page had
+    * to be decompressed.
+    */
+  s8 pages[CTF_MAX_PAGES]; /*
+    * The font page held by each slot, or -1 if
+    * the slot is empty.
+    */
+  u8 order[CTF_MAX_PAGES]; /*
+    * Slot indices ordered from most recently used
+    * to least recently used.
+    */
+
+};
+
+#define CTF_PAGE_CACHE_MAGIC 0x46544343 // "CCTF"
+
+#define CHAPTER_TITLE_VRAM_CACHE_MAX_SLOTS 8
+#define CHAPTER_TITLE_VRAM_CACHE_EMPTY 0xFFFF
+#define CHAPTER_TITLE_VRAM_CACHE_MAGIC 0x56544343 // "CCTV"
+
+struct ChapterTitleVRAMCacheSlot {
+  /*
+   * A chapter title that has been drawn to VRAM.
+   */
+
+  u16 vramTile; /*
+    * The first tile of the title's space in VRAM, or
+    * `CHAPTER_TITLE_VRAM_CACHE_EMPTY` if the slot is empty.
+    */
+  u16 titleID;
+  u32 checksum; /*
+    * A checksum of the title's tiles right after it
+    * was drawn. If the tiles no longer match, something
+    * else has drawn over them.
+    */
+
+};
+
+struct ChapterTitleVRAMCache {
+  /*
+   * This lives at the start of the VRAM cache's space
+   * in EWRAM, and is followed by the cache's slots.
+   */
+
+  u32 magic; /*
+    * This is set to `CHAPTER_TITLE_VRAM_CACHE_MAGIC` once
+    * the cache has been initialized.
+    */
+  u32 hits; /*
+    * The number of times that a title didn't need
+    * to be drawn because it was already in VRAM.
+    */
+  u32 misses; /*
+    * The number of times that a title had to be drawn.
+    */
+  u8 order[CHAPTER_TITLE_VRAM_CACHE_MAX_SLOTS]; /*
+    * Slot indices ordered from most recently used
+    * to least recently used.
+    */
+  struct ChapterTitleVRAMCacheSlot slots[];
 
-  };
 };
 
 extern const u16 gChapterTitleEntryCount;
@@ -352,32 +530,95 @@ extern const u8 gSkirmishStartingChapterTitleID;
 extern const struct ChapterTitleEntry gChapterTitles[];
 extern char* gSpecialChapterTitles[];
 
-extern const struct ChapterTitleFontLookupEntry gCTFLookup[];
+extern const u8 gChapterTitleStripsEnabled;
+extern const u8* gSpecialChapterTitleStrips[];
+
+extern const u8 gChapterTitleStreamsEnabled;
+extern const struct ChapterTitleStream* gSpecialChapterTitleStreams[];
+
 extern const struct FontEntry gCTFMetadata[];
-extern const struct WhitespaceEntry gCTFWhitespace[];
+
+extern const u16 gCTFIndexBlockCount;
+extern const u16 gCTFIndexBlocks[];
+extern const u16 gCTFIndex[];
+
+/*
+ * Kerning is a matrix of signed pixel adjustments with a row
+ * for each left-side kerning class and a column for each
+ * right-side kerning class. Class 0 on either side is
+ * all zeroes, so glyphs that never kern don't need a check.
+ */
+
+extern const u8 gCTFKerningRightClassCount;
+extern const s8 gCTFKerningMatrix[];
+
+extern const struct ChapterTitleGlyphPart gCTFCompositeParts[];
 
 extern const u8* gCTFPageImagePointers[];
 
+/*
+ * Fonts can optionally store each glyph uncompressed in ROM
+ * instead of on compressed font pages. `gCTFGlyphStoreDepth` is
+ * the bit depth of the glyph records, or 0 if the font uses pages.
+ * Each record holds a glyph's rows between its margins, each row
+ * being `(width + 7) / 8` slices of 8 pixels. 2bpp slices are
+ * expanded to 4bpp a byte at a time using `gCTFShadeExpansion`.
+ *
+ * `gCTFGlyphRecordOffsets` has the offset in bytes of each glyph's
+ * record from the start of `gCTFGlyphRecords`, parallel to
+ * `gCTFMetadata`, so that the tables can be assembled as
+ * binaries without any pointers in them.
+ */
+
+extern const u8 gCTFGlyphStoreDepth;
+extern const u16 gCTFShadeExpansion[256];
+extern const u32 gCTFGlyphRecordOffsets[];
+extern const u8 gCTFGlyphRecords[];
+
+extern u32* const gChapterTitleScratch;
+extern struct ChapterTitleRender* const gChapterTitleRenders;
+
+extern const u8 gCTFPageCacheSlotCount;
+extern struct ChapterTitleFontPageCache* const gCTFPageCache;
+
+extern const u8 gChapterTitleVRAMCacheSlotCount;
+extern struct ChapterTitleVRAMCache* const gChapterTitleVRAMCache;
+
 // These are the functions defined in our sources.
 
 // UTF8.c
-int GetUTF8Displacement(char c, int shift);
 int ReadUTF8Character(char* text, int* outputCodepoint);
+void StartUTF8Iterator(struct UTF8Iterator* iterator, char* text);
+int NextUTF8Character(struct UTF8Iterator* iterator);
 
 // DrawChapterTitle.c
 void LoadChapterTitleGfx(int vramTile, unsigned titleID);
-void DrawChapterTitleCharacter(u32* font, u32* dest, const struct FontEntry* fontCharacter, int x);
-int GetChapterTitlePadding(char* text);
+void LoadChapterTitleGfxBatch(const int* vramTiles, const unsigned* titleIDs, int count);
+bool IsChapterTitleInVRAM(int vramTile, unsigned titleID);
+void SetChapterTitleInVRAM(int vramTile, unsigned titleID);
+void ClearChapterTitleVRAMCache(void);
+void LayoutChapterTitle(char* chapterTitle, struct ChapterTitleLayout* layout);
+void LayoutCompiledChapterTitle(const struct ChapterTitleStream* stream, struct ChapterTitleLayout* layout);
+void StartChapterTitleRender(struct ChapterTitleRender* render, void* dest, void* surface, unsigned titleID);
+bool ContinueChapterTitleRender(struct ChapterTitleRender* render, int glyphBudget);
+u32 GetChapterTitleLayoutPages(const struct ChapterTitleLayout* layout);
+void DrawChapterTitleCharacter(u32* font, u32* dest, const struct FontEntry* fontCharacter, int x, int y);
+void DrawChapterTitleGlyphRecord(u32* dest, const struct FontEntry* fontCharacter, int x, int y);
+int GetChapterTitlePadding(const struct ChapterTitleLayout* layout);
 
 // FontUtilities.c
-signed TryGetWhitespaceCharacterWidth(int codepoint);
-int GetInitialFontIndex(int codepoint);
-int ReadChapterTitleUTF8Character(char* chapterTitle, const struct FontEntry** fontCharacter);
-signed TryGetKerningAdjustment(const struct KernRightCharacter* kernableList, int target);
-void SetChapterTitleFontPage(int page);
+int GetChapterTitleGlyphIndex(int codepoint);
+int GetChapterTitleCharacter(int codepoint, const struct FontEntry** fontCharacter);
+int GetKerningAdjustment(const struct FontEntry* left, const struct FontEntry* right);
+u32* SetChapterTitleFontPage(int page);
 void GetChapterTitlePalette(int config, int paletteID);
 
 // ChapterTitleIndexUtilities.c
 char* GetChapterTitle(unsigned titleID);
+const u8* GetChapterTitleStrip(unsigned titleID);
+const struct ChapterTitleStream* GetChapterTitleStream(unsigned titleID);
+
+// Skip Huffman Decompression, or StringPointerFallback.c
+char* GetStringPointerFromIndex(int index);
 
 #endif // GUARD_CTF_H
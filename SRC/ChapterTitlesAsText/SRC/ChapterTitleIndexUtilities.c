@@ -6,26 +6,91 @@
  * Utilities for working with chapter title IDs.
  */
 
+static const struct ChapterTitleEntry* GetChapterTitleEntry(unsigned titleID) {
+  /*
+   * Given a pending chapter title ID, get its entry in
+   * the chapter title table. Unknown IDs get the default
+   * chapter title's entry.
+   */
+
+  if (titleID >= gChapterTitleEntryCount)
+    titleID = gDefaultChapterTitleID;
+
+  return &gChapterTitles[titleID];
+}
+
+static int GetSpecialChapterTitleIndex(unsigned titleID) {
+  /*
+   * Given a pending chapter title ID, get its index in
+   * the special chapter title table, or -1 if it uses
+   * a text ID.
+   */
+
+  const struct ChapterTitleEntry* entry;
+
+  entry = GetChapterTitleEntry(titleID);
+
+  if (entry->specialID >= 0)
+    return -1;
+
+  return ABS(entry->specialID) - 1;
+}
+
 char* GetChapterTitle(unsigned titleID) {
   /*
    * Given a pending chapter title ID, fetch the
    * chapter title text for the chapter.
    */
 
-  const struct ChapterTitleEntry* entry;
-  char* chapterTitle;
+  int specialIndex;
 
-  if (titleID > gChapterTitleEntryCount)
-    titleID = gDefaultChapterTitleID;
+  specialIndex = GetSpecialChapterTitleIndex(titleID);
+  if (specialIndex >= 0)
+    return gSpecialChapterTitles[specialIndex];
+
+  return GetStringPointerFromIndex(GetChapterTitleEntry(titleID)->textID);
+}
+
+const u8* GetChapterTitleStrip(unsigned titleID) {
+  /*
+   * Given a pending chapter title ID, fetch the
+   * pre-rendered graphics for the chapter title.
+   * Returns NULL if the chapter title has to be drawn
+   * using the font.
+   */
+
+  int specialIndex;
+
+  if (!gChapterTitleStripsEnabled)
+    return NULL;
+
+  // Only special chapter titles are known when building.
+
+  specialIndex = GetSpecialChapterTitleIndex(titleID);
+  if (specialIndex < 0)
+    return NULL;
+
+  return gSpecialChapterTitleStrips[specialIndex];
+}
+
+const struct ChapterTitleStream* GetChapterTitleStream(unsigned titleID) {
+  /*
+   * Given a pending chapter title ID, fetch the
+   * compiled glyph stream for the chapter title.
+   * Returns NULL if the chapter title's text has
+   * to be laid out in-game.
+   */
+
+  int specialIndex;
 
-  entry = &gChapterTitles[titleID];
+  if (!gChapterTitleStreamsEnabled)
+    return NULL;
 
-  if (entry->specialID < 0)
-    chapterTitle = gSpecialChapterTitles[ABS(entry->specialID) - 1];
-  else
-    chapterTitle = GetStringFromIndex(entry->textID);
+  specialIndex = GetSpecialChapterTitleIndex(titleID);
+  if (specialIndex < 0)
+    return NULL;
 
-  return chapterTitle;
+  return gSpecialChapterTitleStreams[specialIndex];
 }
 
 int GetChapterTitleID(struct ChapterState* chapter) {
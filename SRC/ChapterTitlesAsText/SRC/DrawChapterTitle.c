@@ -7,6 +7,31 @@
  * chapter titles.
  */
 
+static void FinishChapterTitleRender(struct ChapterTitleRender* render, int vramTile, unsigned titleID) {
+  /*
+   * Draws a whole chapter title to VRAM using `render`.
+   */
+
+  StartChapterTitleRender(render, VRAM + (vramTile * TILE_SIZE_4BPP), gChapterTitleScratch, titleID);
+  render->queueUpload = FALSE;
+
+  while (!ContinueChapterTitleRender(render, CHAPTER_TITLE_MAX_GLYPHS))
+    ;
+}
+
+static void __attribute__((noinline)) FinishChapterTitleRenderOnStack(int vramTile, unsigned titleID) {
+  /*
+   * Draws a whole chapter title to VRAM with its render
+   * state on the stack. This is kept out of line so that
+   * `LoadChapterTitleGfx` only needs the stack space
+   * when there isn't a `gChapterTitleRenders`.
+   */
+
+  struct ChapterTitleRender render;
+
+  FinishChapterTitleRender(&render, vramTile, titleID);
+}
+
 void LoadChapterTitleGfx(int vramTile, unsigned titleID) {
   /*
    * Draw a chapter's title to VRAM using a font.
@@ -14,171 +39,791 @@ void LoadChapterTitleGfx(int vramTile, unsigned titleID) {
    * Like the vanilla FE7 chapter title code, this
    * assumes that you don't have any text control
    * codes inside of your chapter title.
+   *
+   * This draws the whole title at once. Callers that
+   * can spread the work over several frames should use
+   * `StartChapterTitleRender` instead.
+   *
+   * The title is drawn into `gChapterTitleScratch` if
+   * there is one, and then copied to VRAM right away.
+   *
+   * If the title is still in VRAM from the last time
+   * it was drawn there, it isn't drawn again.
    */
 
-  char* chapterTitle;
-  u8* vramPosition;
-  const struct FontEntry* fontCharacter;
-  int characterWidth;
-  int position;
-  const struct FontEntry* previous;
-  signed page;
+  gChapterTitleTileInfo.textTileID = vramTile & 0x3FF;
 
-  chapterTitle = GetChapterTitle(titleID);
-  vramPosition = VRAM + (vramTile * TILE_SIZE_4BPP);
+  if (IsChapterTitleInVRAM(vramTile, titleID))
+    return;
 
-  gChapterTitleTileInfo.textTileID = vramTile & 0x3FF;
+  if (gChapterTitleRenders != NULL)
+    FinishChapterTitleRender(gChapterTitleRenders, vramTile, titleID);
+  else
+    FinishChapterTitleRenderOnStack(vramTile, titleID);
 
-  CpuFastFill(0, (void*)vramPosition, 32 * 2 * TILE_SIZE_4BPP);
+  SetChapterTitleInVRAM(vramTile, titleID);
+}
 
-  position = GetChapterTitlePadding(chapterTitle);
-  fontCharacter = NULL;
-  previous = NULL;
+static struct ChapterTitleVRAMCache* GetChapterTitleVRAMCache(void) {
+  /*
+   * Gets the VRAM cache, initializing it if needed.
+   * Returns NULL if there isn't a cache.
+   */
 
-  page = -1;
+  struct ChapterTitleVRAMCache* cache;
+  int i;
 
-  while (*chapterTitle != MSG_END && *chapterTitle != MSG_PAD) {
+  if (gChapterTitleVRAMCacheSlotCount == 0)
+    return NULL;
 
-    // The output of this can be one of two things:
+  cache = gChapterTitleVRAMCache;
 
-    // When the character is a glyph, `fontCharacter` contains a
-    // pointer to the glyph's metadata and `characterWidth` is
-    // the number of bytes to advance in the text stream.
+  if (cache->magic != CHAPTER_TITLE_VRAM_CACHE_MAGIC) {
 
-    // When the character is whitespace, `fontCharacter` contains
-    // NULL and `characterWidth` is a packed value of the form
-    // `(whitespaceWidth << 16) | width` where `whitespaceWidth`
-    // is the width of the glyph in pixels and `width` is the width
-    // of the character in bytes.
+    for (i = 0; i < gChapterTitleVRAMCacheSlotCount; i++) {
+      cache->slots[i].vramTile = CHAPTER_TITLE_VRAM_CACHE_EMPTY;
+      cache->order[i] = i;
+    }
 
-    characterWidth = ReadChapterTitleUTF8Character(chapterTitle, &fontCharacter);
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->magic = CHAPTER_TITLE_VRAM_CACHE_MAGIC;
 
-    if (fontCharacter == NULL) {
+  }
 
-      position += (characterWidth >> 16);
-      previous = NULL;
-      chapterTitle += (characterWidth & 0xFFFF);
+  return cache;
+}
 
-    } else {
+static u32 GetChapterTitleChecksum(int vramTile) {
+  /*
+   * Gets a checksum of a chapter title's tiles in VRAM.
+   *
+   * This is much cheaper than drawing the title, and catches
+   * anything that has drawn over the title, including
+   * clearing its tiles.
+   */
 
-      if ((previous != NULL) && (previous->matchList != NULL))
-        position += TryGetKerningAdjustment(previous->matchList, fontCharacter->codepoint);
+  const u32* tiles;
+  u32 checksum;
+  int i;
 
-      if (fontCharacter->page != page) {
+  tiles = (const u32*)(VRAM + (vramTile * TILE_SIZE_4BPP));
+  checksum = 0;
 
-        SetChapterTitleFontPage(fontCharacter->page);
-        page = fontCharacter->page;
+  for (i = 0; i < (CHAPTER_TITLE_STRIP_SIZE / 4); i++)
+    checksum = ((checksum << 5) | (checksum >> 27)) + tiles[i];
 
-      }
+  return checksum;
+}
 
-      DrawChapterTitleCharacter(
-        (u32*)gGenericBuffer,
-        (u32*)vramPosition,
-        fontCharacter,
-        position
-        );
+static void UseChapterTitleVRAMCacheSlot(struct ChapterTitleVRAMCache* cache, int i) {
+  /*
+   * Moves the `i`th slot in the cache's order to the front.
+   */
 
-      position += fontCharacter->width - 1;
-      previous = fontCharacter;
+  int slot;
+
+  slot = cache->order[i];
+
+  for (; i > 0; i--)
+    cache->order[i] = cache->order[i - 1];
+
+  cache->order[0] = slot;
+}
+
+bool IsChapterTitleInVRAM(int vramTile, unsigned titleID) {
+  /*
+   * Checks whether a chapter title is still in VRAM
+   * at `vramTile` from the last time that it was drawn there.
+   */
 
-      chapterTitle += characterWidth;
+  struct ChapterTitleVRAMCache* cache;
+  struct ChapterTitleVRAMCacheSlot* slot;
+  int i;
+
+  cache = GetChapterTitleVRAMCache();
+  if (cache == NULL)
+    return FALSE;
+
+  for (i = 0; i < gChapterTitleVRAMCacheSlotCount; i++) {
+
+    slot = &cache->slots[cache->order[i]];
+
+    if (slot->vramTile != vramTile || slot->titleID != titleID)
+      continue;
+
+    if (slot->checksum != GetChapterTitleChecksum(vramTile)) {
+
+      // Something has drawn over the title.
+
+      slot->vramTile = CHAPTER_TITLE_VRAM_CACHE_EMPTY;
+      break;
 
     }
+
+    cache->hits++;
+    UseChapterTitleVRAMCacheSlot(cache, i);
+
+    return TRUE;
   }
+
+  cache->misses++;
+
+  return FALSE;
 }
 
-void DrawChapterTitleCharacter(u32* font, u32* dest, const struct FontEntry* fontCharacter, int x) {
+void SetChapterTitleInVRAM(int vramTile, unsigned titleID) {
   /*
-   * Draws a single glyph to VRAM, offset `x` pixels horizontally
-   * within the space allocated for the chapter title.
+   * Remembers that a chapter title has just been
+   * drawn to VRAM at `vramTile`.
+   */
+
+  struct ChapterTitleVRAMCache* cache;
+  struct ChapterTitleVRAMCacheSlot* slot;
+  int i;
+  int replace;
+
+  cache = GetChapterTitleVRAMCache();
+  if (cache == NULL)
+    return;
+
+  // Titles that were drawn over are gone, and their slots
+  // are reused before any others. Otherwise, we reuse the
+  // least recently used slot.
+
+  replace = gChapterTitleVRAMCacheSlotCount - 1;
+
+  for (i = gChapterTitleVRAMCacheSlotCount - 1; i >= 0; i--) {
+
+    slot = &cache->slots[cache->order[i]];
+
+    if (slot->vramTile != CHAPTER_TITLE_VRAM_CACHE_EMPTY) {
+
+      if (ABS(slot->vramTile - vramTile) >= (CHAPTER_TITLE_STRIP_SIZE / TILE_SIZE_4BPP))
+        continue;
+
+      slot->vramTile = CHAPTER_TITLE_VRAM_CACHE_EMPTY;
+
+    }
+
+    if (cache->slots[cache->order[replace]].vramTile != CHAPTER_TITLE_VRAM_CACHE_EMPTY)
+      replace = i;
+
+  }
+
+  slot = &cache->slots[cache->order[replace]];
+
+  slot->vramTile = vramTile;
+  slot->titleID = titleID;
+  slot->checksum = GetChapterTitleChecksum(vramTile);
+
+  UseChapterTitleVRAMCacheSlot(cache, replace);
+}
+
+void ClearChapterTitleVRAMCache(void) {
+  /*
+   * Forgets every chapter title in the VRAM cache.
    *
-   * The way this works is taken from vanilla FE7U. See `DOC/FE7_ChapterTitlesAsText.c`.
+   * The checksums catch almost anything that draws over
+   * a title, but code that knows that it has replaced a
+   * title's tiles can call this to be sure.
    */
 
-  int currentColumn;
-  int currentRow;
+  struct ChapterTitleVRAMCache* cache;
+  int i;
 
-  int fontXPosition;
-  int fontYPosition;
+  cache = GetChapterTitleVRAMCache();
+  if (cache == NULL)
+    return;
 
-  int destXPosition;
+  for (i = 0; i < gChapterTitleVRAMCacheSlotCount; i++)
+    cache->slots[i].vramTile = CHAPTER_TITLE_VRAM_CACHE_EMPTY;
+}
 
-  int sliceXPosition;
-  u32* glyphPosition;
-  u32* destPosition;
-  int shift;
-  u32 fontSlice;
+void StartChapterTitleRender(struct ChapterTitleRender* render, void* dest, void* surface, unsigned titleID) {
+  /*
+   * Begins drawing a chapter's title to `dest`, which can
+   * be anywhere in VRAM, such as BG or OBJ tiles. Nothing is
+   * drawn until `ContinueChapterTitleRender` is called.
+   *
+   * If `surface` isn't NULL, the title is drawn into it
+   * and uploaded to `dest` once finished, during the next
+   * VBlank. `surface` has to be word-aligned, large enough for
+   * `CHAPTER_TITLE_STRIP_SIZE` bytes, and left alone until
+   * the upload has happened, so renders that are in progress
+   * at the same time each need their own surface.
+   *
+   * Otherwise, the title's space in VRAM is cleared here and
+   * the title will appear glyph-by-glyph as it's rendered.
+   */
 
-  fontXPosition = (fontCharacter->tile % 32) * 8;
-  fontYPosition = (fontCharacter->tile / 32) * 8;
+  const struct ChapterTitleStream* stream;
 
-  currentRow = fontCharacter->upperMargin;
+  render->dest = (u32*)dest;
+  render->surface = (surface != NULL) ? (u32*)surface : render->dest;
+  render->queueUpload = TRUE;
+
+  // Pre-rendered chapter titles already have their
+  // padding and empty space baked in.
+
+  render->strip = GetChapterTitleStrip(titleID);
+  if (render->strip != NULL) {
+    render->surface = render->dest;
+    return;
+  }
+
+  // Compiled chapter titles are already laid out.
+
+  stream = GetChapterTitleStream(titleID);
+  if (stream != NULL)
+    LayoutCompiledChapterTitle(stream, &render->layout);
+  else
+    LayoutChapterTitle(GetChapterTitle(titleID), &render->layout);
+
+  CpuFastFill(0, (void*)render->surface, CHAPTER_TITLE_STRIP_SIZE);
+
+  render->padding = GetChapterTitlePadding(&render->layout);
+  render->pendingPages = GetChapterTitleLayoutPages(&render->layout);
+  render->page = 0;
+  render->nextGlyph = 0;
+}
+
+static int DrawChapterTitlePageGlyphs(struct ChapterTitleRender* render, u32* font, int glyphBudget) {
+  /*
+   * Draws a render's glyphs that are on its current font
+   * page, starting from `nextGlyph`, until `glyphBudget` runs
+   * out. `font` is the decompressed page, or NULL if the font
+   * stores glyphs individually.
+   *
+   * Returns what's left of the budget. `nextGlyph` is left at
+   * the first glyph that wasn't drawn, or past the end of the
+   * layout if every glyph on the page has been drawn.
+   */
+
+  const struct ChapterTitleGlyph* glyph;
+
+  glyph = &render->layout.glyphs[render->nextGlyph];
+
+  for (; render->nextGlyph < render->layout.count; render->nextGlyph++, glyph++) {
+
+    if (glyph->fontCharacter->page != render->page)
+      continue;
+
+    if (glyphBudget <= 0)
+      break;
+
+    if (font != NULL)
+      DrawChapterTitleCharacter(font, render->surface, glyph->fontCharacter, render->padding + glyph->x, glyph->y);
+    else
+      DrawChapterTitleGlyphRecord(render->surface, glyph->fontCharacter, render->padding + glyph->x, glyph->y);
+
+    glyphBudget--;
+
+  }
+
+  return glyphBudget;
+}
+
+bool ContinueChapterTitleRender(struct ChapterTitleRender* render, int glyphBudget) {
+  /*
+   * Draws up to `glyphBudget` more glyphs of a chapter
+   * title started with `StartChapterTitleRender`.
+   * Returns TRUE once the whole title has been drawn
+   * and its upload, if any, has been queued.
+   *
+   * Glyphs are drawn grouped by their font page rather than
+   * in text order, so each page that the title uses is only
+   * fetched once per call. Glyphs are ORed into place, so the
+   * order that they're drawn in doesn't change the result.
+   *
+   * Without a font page cache, fetching a page means
+   * decompressing it, so every glyph on a page is drawn once
+   * the page has been fetched, even past the budget. This way,
+   * each page is only decompressed once per title.
+   */
+
+  u32* font;
+  int pageBudget;
+
+  if (render->strip != NULL) {
+    Decompress((void*)render->strip, (void*)render->dest);
+    render->strip = NULL;
+    render->pendingPages = 0;
+  }
+
+  while (render->pendingPages != 0) {
+
+    if (!(render->pendingPages & (1 << render->page))) {
+      render->page++;
+      continue;
+    }
+
+    // Don't fetch a page that there's no budget left to draw.
+
+    if (glyphBudget <= 0)
+      return FALSE;
+
+    // The page has to be fetched again when resuming, as
+    // something else may have used the buffer since the
+    // last call.
+
+    // Fonts that store glyphs individually don't have pages.
+
+    font = NULL;
+    pageBudget = glyphBudget;
+
+    if (gCTFGlyphStoreDepth == 0) {
+
+      font = SetChapterTitleFontPage(render->page);
+
+      if (gCTFPageCacheSlotCount == 0)
+        pageBudget = CHAPTER_TITLE_MAX_GLYPHS;
+
+    }
+
+    glyphBudget -= pageBudget - DrawChapterTitlePageGlyphs(render, font, pageBudget);
+
+    if (render->nextGlyph < render->layout.count)
+      return FALSE;
+
+    render->pendingPages &= ~(1 << render->page);
+    render->page++;
+    render->nextGlyph = 0;
+  }
 
-  while (currentRow < fontCharacter->lowerMargin) {
+  // The finished title is moved to VRAM in a single transfer.
 
-    currentColumn = 0;
-    while (currentColumn < fontCharacter->width) {
+  if (render->surface != render->dest) {
 
-      sliceXPosition = fontXPosition + currentColumn;
-      destXPosition = x + currentColumn;
+    if (render->queueUpload)
+      RegisterTileGraphics(render->surface, render->dest, CHAPTER_TITLE_STRIP_SIZE);
+    else
+      CpuFastCopy(render->surface, render->dest, CHAPTER_TITLE_STRIP_SIZE);
 
-      glyphPosition = ((sliceXPosition >> 3) << 3) + font + (((fontYPosition + currentRow) >> 3) << (3 + 5)) + ((fontYPosition + currentRow) & 7);
+    render->surface = render->dest;
+  }
+
+  return TRUE;
+}
+
+void LoadChapterTitleGfxBatch(const int* vramTiles, const unsigned* titleIDs, int count) {
+  /*
+   * Draws several chapter titles, like calling
+   * `LoadChapterTitleGfx` for each of them, such as for
+   * the save files in the save menu.
+   *
+   * Every title is laid out first, and then each font page
+   * that any of them use is fetched once and all of the glyphs
+   * on it are drawn, for every title. This way, titles that
+   * share pages don't each decompress them.
+   *
+   * The titles are drawn directly into VRAM, since there's
+   * only a single scratch surface. Titles are drawn
+   * `CHAPTER_TITLE_BATCH_SIZE` at a time using the render
+   * states in `gChapterTitleRenders`. Those are too large
+   * for the stack, so without them, each title is drawn
+   * on its own by `LoadChapterTitleGfx`.
+   */
+
+  struct ChapterTitleRender* renders;
+  struct ChapterTitleRender* render;
+  u32 pages;
+  u32 drawing;
+  u32* font;
+  int batchCount;
+  int page;
+  int i;
+
+  renders = gChapterTitleRenders;
+
+  if (renders == NULL) {
+
+    for (i = 0; i < count; i++)
+      LoadChapterTitleGfx(vramTiles[i], titleIDs[i]);
+
+    return;
+  }
 
-      shift = (sliceXPosition & 7) << 2;
+  for (; count > 0; count -= batchCount, vramTiles += batchCount, titleIDs += batchCount) {
 
-      fontSlice = *glyphPosition & (15 << shift);
-      if (fontSlice) {
+    batchCount = (count < CHAPTER_TITLE_BATCH_SIZE) ? count : CHAPTER_TITLE_BATCH_SIZE;
 
-        destPosition = ((destXPosition >> 3) << 3) + dest + ((currentRow >> 3) << (3 + 5)) + (currentRow & 7);
+    pages = 0;
+    drawing = 0;
 
-        fontSlice = fontSlice >> shift;
-        fontSlice = fontSlice << ((destXPosition & 7) << 2);
+    for (i = 0, render = renders; i < batchCount; i++, render++) {
 
-        *destPosition |= fontSlice;
+      gChapterTitleTileInfo.textTileID = vramTiles[i] & 0x3FF;
+
+      if (IsChapterTitleInVRAM(vramTiles[i], titleIDs[i]))
+        continue;
+
+      StartChapterTitleRender(render, VRAM + (vramTiles[i] * TILE_SIZE_4BPP), NULL, titleIDs[i]);
+
+      // Pre-rendered titles don't use the font,
+      // so they're finished right away.
+
+      if (render->strip != NULL) {
+        ContinueChapterTitleRender(render, 0);
+        SetChapterTitleInVRAM(vramTiles[i], titleIDs[i]);
+        continue;
       }
-      currentColumn++;
+
+      pages |= render->pendingPages;
+      drawing |= 1 << i;
+
+    }
+
+    for (page = 0; pages != 0; page++) {
+
+      if (!(pages & (1 << page)))
+        continue;
+
+      pages &= ~(1 << page);
+
+      font = (gCTFGlyphStoreDepth == 0) ? SetChapterTitleFontPage(page) : NULL;
+
+      for (i = 0, render = renders; i < batchCount; i++, render++) {
+
+        if (!(drawing & (1 << i)))
+          continue;
+
+        render->page = page;
+        render->nextGlyph = 0;
+
+        DrawChapterTitlePageGlyphs(render, font, CHAPTER_TITLE_MAX_GLYPHS);
+
+      }
+    }
+
+    for (i = 0; i < batchCount; i++) {
+      if (drawing & (1 << i))
+        SetChapterTitleInVRAM(vramTiles[i], titleIDs[i]);
     }
-    currentRow++;
   }
 }
 
-int GetChapterTitlePadding(char* text) {
+static struct ChapterTitleGlyph* AddChapterTitleGlyph(struct ChapterTitleLayout* layout, struct ChapterTitleGlyph* glyph, const struct FontEntry* fontCharacter, int x) {
   /*
-   * Gets the number of pixels to indent a chapter title by.
+   * Places a glyph at `glyph` in a layout, splitting
+   * composite glyphs into their parts. Returns where
+   * the next glyph goes.
+   *
+   * Glyphs past `CHAPTER_TITLE_MAX_GLYPHS` are dropped.
    */
 
-  int position;
+  const struct ChapterTitleGlyphPart* part;
+  const struct ChapterTitleGlyph* end;
+
+  end = &layout->glyphs[CHAPTER_TITLE_MAX_GLYPHS];
+
+  if (fontCharacter->composite == 0) {
+
+    if (glyph < end) {
+
+      glyph->fontCharacter = fontCharacter;
+      glyph->x = x;
+      glyph->y = 0;
+      glyph++;
+
+    }
+
+    return glyph;
+  }
+
+  part = &gCTFCompositeParts[fontCharacter->composite];
+
+  for (; (part->glyph != CTF_INDEX_MISSING) && (glyph < end); part++, glyph++) {
+
+    glyph->fontCharacter = &gCTFMetadata[part->glyph];
+    glyph->x = x + part->x;
+    glyph->y = part->y;
+
+  }
+
+  return glyph;
+}
+
+void LayoutChapterTitle(char* chapterTitle, struct ChapterTitleLayout* layout) {
+  /*
+   * Lays out a chapter title's glyphs, finding each
+   * glyph's position relative to the start of the title
+   * along with the width of the whole title.
+   *
+   * Glyphs past `CHAPTER_TITLE_MAX_GLYPHS` are dropped.
+   */
+
+  struct UTF8Iterator text;
+  int codepoint;
   const struct FontEntry* fontCharacter;
-  int characterWidth;
+  int whitespaceWidth;
+  int position;
   const struct FontEntry* previous;
+  struct ChapterTitleGlyph* glyph;
 
   position = 0;
-  previous = NULL;
   fontCharacter = NULL;
+  previous = NULL;
+  glyph = layout->glyphs;
+
+  StartUTF8Iterator(&text, chapterTitle);
+
+  while (TRUE) {
 
-  while (*text != MSG_END && *text != MSG_PAD) {
+    codepoint = NextUTF8Character(&text);
 
-    characterWidth = ReadChapterTitleUTF8Character(text, &fontCharacter);
+    if (codepoint == MSG_END || codepoint == MSG_PAD)
+      break;
+
+    // When the character is a glyph, `fontCharacter` contains a
+    // pointer to the glyph's metadata.
+
+    // When the character is whitespace, `fontCharacter` contains
+    // NULL and `whitespaceWidth` is the width of the whitespace
+    // in pixels.
+
+    whitespaceWidth = GetChapterTitleCharacter(codepoint, &fontCharacter);
 
     if (fontCharacter == NULL) {
 
-      position += (characterWidth >> 16);
+      position += whitespaceWidth;
       previous = NULL;
-      text += (characterWidth & 0xFFFF);
 
     } else {
 
-      if ((previous != NULL) && (previous->matchList != NULL))
-        position += TryGetKerningAdjustment(previous->matchList, fontCharacter->codepoint);
+      if (previous != NULL)
+        position += GetKerningAdjustment(previous, fontCharacter);
+
+      glyph = AddChapterTitleGlyph(layout, glyph, fontCharacter, position);
 
       position += fontCharacter->width - 1;
       previous = fontCharacter;
 
-      text += characterWidth;
+    }
+  }
+
+  layout->count = glyph - layout->glyphs;
+  layout->width = position;
+}
+
+void LayoutCompiledChapterTitle(const struct ChapterTitleStream* stream, struct ChapterTitleLayout* layout) {
+  /*
+   * Expands a compiled chapter title into a layout.
+   *
+   * Compiled titles store their padding rather than their
+   * width, so the layout's width is set to whatever
+   * gives the same padding.
+   */
+
+  const u8* entry;
+  int position;
+  int i;
+  struct ChapterTitleGlyph* glyph;
+
+  position = 0;
+  entry = stream->glyphs;
+  glyph = layout->glyphs;
+
+  for (i = 0; i < stream->count; i++, entry += 3) {
+
+    position += entry[2];
+
+    glyph = AddChapterTitleGlyph(layout, glyph, &gCTFMetadata[entry[0] | (entry[1] << 8)], position);
+
+  }
+
+  layout->count = glyph - layout->glyphs;
+  layout->width = CHAPTER_TITLE_WIDTH - (stream->padding * 2);
+}
+
+u32 GetChapterTitleLayoutPages(const struct ChapterTitleLayout* layout) {
+  /*
+   * Gets a bitfield of the font pages that a
+   * laid-out chapter title uses.
+   */
+
+  u32 pages;
+  int i;
+
+  pages = 0;
+  for (i = 0; i < layout->count; i++)
+    pages |= 1 << layout->glyphs[i].fontCharacter->page;
+
+  return pages;
+}
+
+static inline void OrChapterTitleSlice(u32* destRow, int column, u32 fontSlice, int shift) {
+  /*
+   * ORs 8 pixels of a glyph row into place, splitting them
+   * across the two destination tile rows that they overlap.
+   * `destRow` is the row within the title's first column of
+   * tiles, and `column` is the tile column of the slice's
+   * left edge.
+   *
+   * Titles that are too wide for their space end up with
+   * glyphs partly outside of it, so any pixels that would
+   * land outside of the title's columns are dropped.
+   */
+
+  if ((unsigned)column < CHAPTER_TITLE_STRIP_COLUMNS)
+    destRow[column << 3] |= fontSlice << shift;
+
+  column++;
+
+  if ((shift != 0) && ((unsigned)column < CHAPTER_TITLE_STRIP_COLUMNS))
+    destRow[column << 3] |= fontSlice >> (32 - shift);
+}
+
+void DrawChapterTitleCharacter(u32* font, u32* dest, const struct FontEntry* fontCharacter, int x, int y) {
+  /*
+   * Draws a single glyph to VRAM, offset `x` pixels horizontally
+   * and `y` pixels vertically within the space allocated for the
+   * chapter title. Rows and columns that would be moved out of
+   * the title's space are skipped.
+   *
+   * Rather than going pixel-by-pixel like vanilla FE7U does
+   * (see `DOC/FE7_ChapterTitlesAsText.c`), this works on whole
+   * rows of tiles. A 4bpp tile row is a single word, so each
+   * glyph row is read a word at a time, shifted by `x & 7`
+   * pixels, and split across the two destination tile rows
+   * that it overlaps.
+   */
+
+  int currentRow;
+  int lastRow;
+  int destY;
+  int currentSlice;
+  int sliceCount;
+
+  int shift;
+  u32 lastSliceMask;
+
+  u32* glyphRow;
+  u32* destRow;
+  u32 fontSlice;
+
+  // Each slice is 8 pixels of a glyph row, or one tile's row.
+  // Pixels past the glyph's width are masked off of the last slice.
+
+  sliceCount = (fontCharacter->width + 7) >> 3;
+  lastSliceMask = (fontCharacter->width & 7)
+    ? ((1 << ((fontCharacter->width & 7) << 2)) - 1)
+    : 0xFFFFFFFF
+  ;
+
+  shift = (x & 7) << 2;
+
+  currentRow = fontCharacter->upperMargin;
+  lastRow = fontCharacter->lowerMargin;
+
+  if ((currentRow + y) < 0)
+    currentRow = -y;
+
+  if ((lastRow + y) > CHAPTER_TITLE_HEIGHT)
+    lastRow = CHAPTER_TITLE_HEIGHT - y;
+
+  while (currentRow < lastRow) {
+
+    // Tiles within a font page are 32 tiles wide, so the
+    // next row of tiles is 32 * 8 words away. The same is true
+    // of the chapter title's space in VRAM.
+
+    destY = currentRow + y;
+
+    glyphRow = font + (fontCharacter->tile << 3) + ((currentRow >> 3) << (3 + 5)) + (currentRow & 7);
+    destRow = dest + ((destY >> 3) << (3 + 5)) + (destY & 7);
+
+    for (currentSlice = 0; currentSlice < sliceCount; currentSlice++) {
+
+      fontSlice = glyphRow[currentSlice << 3];
+
+      if (currentSlice == (sliceCount - 1))
+        fontSlice &= lastSliceMask;
+
+      if (fontSlice)
+        OrChapterTitleSlice(destRow, (x >> 3) + currentSlice, fontSlice, shift);
 
     }
 
+    currentRow++;
+  }
+}
+
+void DrawChapterTitleGlyphRecord(u32* dest, const struct FontEntry* fontCharacter, int x, int y) {
+  /*
+   * Draws a single glyph from the font's glyph records,
+   * offset `x` pixels horizontally and `y` pixels
+   * vertically. This works just like
+   * `DrawChapterTitleCharacter`, but the glyph is read
+   * straight from ROM.
+   *
+   * Records are already trimmed to the glyph's margins and
+   * its pixels past its width are already cleared.
+   */
+
+  int currentRow;
+  int lastRow;
+  int destY;
+  int currentSlice;
+  int sliceCount;
+
+  int shift;
+
+  const u16* record2bpp;
+  const u32* record4bpp;
+  u32* destRow;
+  u32 fontSlice;
+
+  sliceCount = (fontCharacter->width + 7) >> 3;
+  shift = (x & 7) << 2;
+
+  currentRow = fontCharacter->upperMargin;
+  lastRow = fontCharacter->lowerMargin;
+
+  if ((currentRow + y) < 0)
+    currentRow = -y;
+
+  if ((lastRow + y) > CHAPTER_TITLE_HEIGHT)
+    lastRow = CHAPTER_TITLE_HEIGHT - y;
+
+  // Records start at the upper margin, so any skipped
+  // rows have to be skipped in the record, too.
+
+  record2bpp = (const u16*)&gCTFGlyphRecords[gCTFGlyphRecordOffsets[fontCharacter - gCTFMetadata]];
+  record4bpp = (const u32*)&gCTFGlyphRecords[gCTFGlyphRecordOffsets[fontCharacter - gCTFMetadata]];
+
+  record2bpp += (currentRow - fontCharacter->upperMargin) * sliceCount;
+  record4bpp += (currentRow - fontCharacter->upperMargin) * sliceCount;
+
+  for (; currentRow < lastRow; currentRow++) {
+
+    destY = currentRow + y;
+    destRow = dest + ((destY >> 3) << (3 + 5)) + (destY & 7);
+
+    for (currentSlice = 0; currentSlice < sliceCount; currentSlice++) {
+
+      if (gCTFGlyphStoreDepth == 2) {
+
+        fontSlice = *record2bpp++;
+        fontSlice = gCTFShadeExpansion[fontSlice & 0xFF] | (gCTFShadeExpansion[fontSlice >> 8] << 16);
+
+      } else {
+
+        fontSlice = *record4bpp++;
+
+      }
+
+      if (fontSlice)
+        OrChapterTitleSlice(destRow, (x >> 3) + currentSlice, fontSlice, shift);
+
+    }
   }
+}
+
+int GetChapterTitlePadding(const struct ChapterTitleLayout* layout) {
+  /*
+   * Gets the number of pixels to indent a chapter title by.
+   */
 
-  return ((CHAPTER_TITLE_WIDTH - position) / 2);
+  return ((CHAPTER_TITLE_WIDTH - layout->width) / 2);
 }
@@ -6,148 +6,143 @@
  * Utilities for working with the chapter title font.
  */
 
-signed TryGetWhitespaceCharacterWidth(int codepoint) {
+int GetChapterTitleGlyphIndex(int codepoint) {
   /*
-   * If the character is a whitespace character, return
-   * the character's width in pixels.
+   * Looks up a codepoint in the font's index.
    *
-   * If the character is not a whitespace character, return -1.
+   * Returns the glyph's index in the font metadata table,
+   * `CTF_INDEX_WHITESPACE | width` for whitespace characters,
+   * or `CTF_INDEX_MISSING` if the font doesn't have the character.
    */
 
-  signed width;
-  int i;
-  const struct WhitespaceEntry* entry;
-
-  width = -1;
-
-  i = 0;
-  entry = &gCTFWhitespace[i];
-  while (entry->terminator != TERMINATOR) {
+  unsigned block;
 
-    if (entry->codepoint == codepoint) {
+  block = codepoint >> CTF_INDEX_BLOCK_SHIFT;
+  if (block >= gCTFIndexBlockCount)
+    return CTF_INDEX_MISSING;
 
-      width = entry->width;
-      break;
-
-    }
+  block = gCTFIndexBlocks[block];
+  if (block == CTF_INDEX_MISSING)
+    return CTF_INDEX_MISSING;
 
-    entry = &gCTFWhitespace[i++];
-
-  }
-
-  return width;
+  return gCTFIndex[(block << CTF_INDEX_BLOCK_SHIFT) | (codepoint & (CTF_INDEX_BLOCK_SIZE - 1))];
 }
 
-int GetInitialFontIndex(int codepoint) {
+int GetChapterTitleCharacter(int codepoint, const struct FontEntry** fontCharacter) {
   /*
-   * Get the starting metadata chunk index
-   * of the codepoint.
+   * Maps a character to the chapter title font, storing
+   * the font glyph entry in `fontCharacter`.
+   *
+   * If the character is actually a whitespace character,
+   * `fontCharacter` will be NULL and the width of the
+   * whitespace in pixels is returned. Otherwise this
+   * returns 0.
    */
 
-  int i;
   int index;
-  const struct ChapterTitleFontLookupEntry* entry;
 
-  i = 0;
-  entry = &gCTFLookup[i];
-  index = entry->index;
-  while (entry->terminator != TERMINATOR) {
+  *fontCharacter = NULL;
 
-    if (entry->codepoint > codepoint) {
-      break;
-    }
+  index = GetChapterTitleGlyphIndex(codepoint);
 
-    index = entry->index;
-    entry = &gCTFLookup[i++];
+  // Characters that aren't in the font are
+  // treated like zero-width whitespace.
 
-  }
+  if (index == CTF_INDEX_MISSING)
+    return 0;
+
+  if (index & CTF_INDEX_WHITESPACE)
+    return (index & ~CTF_INDEX_WHITESPACE);
 
-  return index;
+  *fontCharacter = &gCTFMetadata[index];
+
+  return 0;
 }
 
-int ReadChapterTitleUTF8Character(char* chapterTitle, const struct FontEntry** fontCharacter) {
+int GetKerningAdjustment(const struct FontEntry* left, const struct FontEntry* right) {
   /*
-   * Read a single UTF-8 encoded character from a
-   * string and map it to the chapter title font.
-   * Returns the width of the character in bytes
-   * and the font glyph entry in `fontCharacter`.
-   *
-   * If the character is actually a whitespace character,
-   * the `fontcharacter` will be NULL and the width returned
-   * will be a packed value of the form `(whitespaceWidth << 16) | width`
-   * where `whitespaceWidth` is the width of the glyph in pixels
-   * and `width` is the width of the character in bytes.
+   * Gets the kerning adjustment between two
+   * characters. Returns 0 if the characters don't kern.
+   */
+
+  return gCTFKerningMatrix[(left->leftKerningClass * gCTFKerningRightClassCount) + right->rightKerningClass];
+}
+
+u32* SetChapterTitleFontPage(int page) {
+  /*
+   * Gets the requested chapter title font page,
+   * decompressing it if it isn't already in the
+   * font page cache. Returns a pointer to the
+   * decompressed page.
    *
-   * Like the vanilla FE7 chapter title code, this
-   * assumes that you don't have any text control
-   * codes inside of your chapter title.
+   * Without a cache, pages are decompressed
+   * into `gGenericBuffer`.
    */
 
-  int codepoint;
-  int width;
-  signed whitespaceWidth;
+  struct ChapterTitleFontPageCache* cache;
+  u32* buffers;
+  int count;
   int i;
-  const struct FontEntry* entry;
-
-  *fontCharacter = NULL;
+  int slot;
 
-  width = ReadUTF8Character(chapterTitle, &codepoint);
+  count = gCTFPageCacheSlotCount;
 
-  whitespaceWidth = TryGetWhitespaceCharacterWidth(codepoint);
-  if (whitespaceWidth != -1) {
-    return ((whitespaceWidth << 16) | width);
+  if (count == 0) {
+    Decompress((void*)(gCTFPageImagePointers[page]), (void*)gGenericBuffer);
+    return (u32*)gGenericBuffer;
   }
 
-  i = GetInitialFontIndex(codepoint);
-  entry = &gCTFMetadata[i];
-  while (entry->terminator != TERMINATOR) {
+  cache = gCTFPageCache;
+  buffers = (u32*)(cache + 1);
 
-    if (entry->codepoint == codepoint) {
-      *fontCharacter = entry;
-      break;
+  if (cache->magic != CTF_PAGE_CACHE_MAGIC) {
+
+    for (i = 0; i < count; i++) {
+      cache->pages[i] = -1;
+      cache->order[i] = i;
     }
 
-    entry = &gCTFMetadata[i++];
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->magic = CTF_PAGE_CACHE_MAGIC;
 
   }
 
-  // If the character isn't in the font.
+  // Look for the page from most to least recently used.
+  // If it's missing, we reuse the least recently used slot.
 
-  if (entry->terminator == TERMINATOR) {
-    fontCharacter = NULL;
-    return ((0 << 16) | width);
+  for (i = 0; i < (count - 1); i++) {
+    if (cache->pages[cache->order[i]] == page)
+      break;
   }
 
-  return width;
-}
+  slot = cache->order[i];
 
-signed TryGetKerningAdjustment(const struct KernRightCharacter* kernableList, int target) {
-  /*
-   * Tries to get the kerning adjustment between two
-   * characters. Returns 0 if the characters don't kern.
-   */
+  if (cache->pages[slot] == page) {
 
-  int adjustment = 0;
+    cache->hits++;
 
-  while (kernableList->terminator != TERMINATOR) {
+  } else {
 
-    if (kernableList->codepoint == target) {
-      adjustment = kernableList->leftAdjust;
-      break;
-    }
+    cache->misses++;
+
+    // Invalidate the slot first in case something
+    // interrupts the decompression.
+
+    cache->pages[slot] = -1;
+    Decompress((void*)(gCTFPageImagePointers[page]), (void*)(buffers + (slot * (CTF_PAGE_SIZE / 4))));
+    cache->pages[slot] = page;
 
-    kernableList++;
   }
 
-  return adjustment;
-}
+  // Move the slot to the front.
 
-void SetChapterTitleFontPage(int page) {
-  /*
-   * Copies the requested chapter title font
-   * page into VRAM.
-   */
-  Decompress((void*)(gCTFPageImagePointers[page]), (void*)gGenericBuffer);
+  for (; i > 0; i--)
+    cache->order[i] = cache->order[i - 1];
+
+  cache->order[0] = slot;
+
+  return buffers + (slot * (CTF_PAGE_SIZE / 4));
 }
 
 void GetChapterTitlePalette(int config, int paletteID) {
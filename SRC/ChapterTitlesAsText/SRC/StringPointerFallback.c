@@ -0,0 +1,13 @@
+#include "gbafe.h"
+#include "CTF.h"
+
+char* GetStringPointerFromIndex(int index) {
+  /*
+   * Skip Huffman Decompression provides this, and lets
+   * uncompressed text entries be read without copying them.
+   * This is only installed without it, when every text entry
+   * is compressed and has to be decoded anyway.
+   */
+
+  return GetStringFromIndex(index);
+}
@@ -1,4 +1,6 @@
 
+#include <stdint.h>
+
 #include "gbafe.h"
 #include "CTF.h"
 
@@ -6,47 +8,117 @@
  * UTF-8 text utilities
  */
 
-int GetUTF8Displacement(char c, int shift) {
+static const u8 sUTF8SequenceLengths[32] = {
   /*
-   * Gets the size of a UTF-8 encoded character
-   * in bytes.
+   * The length of a UTF-8 sequence in bytes, indexed
+   * by the top five bits of its first byte. Bytes that
+   * can't start a sequence have a length of 0.
    */
 
-  if (((c << shift) & 0x80) == 0)
-    return shift;
-  else
-    return GetUTF8Displacement(c, shift + 1);
-}
+  1, 1, 1, 1, 1, 1, 1, 1, // 0x00 - 0x3F
+  1, 1, 1, 1, 1, 1, 1, 1, // 0x40 - 0x7F
+  0, 0, 0, 0, 0, 0, 0, 0, // 0x80 - 0xBF, continuation bytes
+  2, 2, 2, 2,             // 0xC0 - 0xDF
+  3, 3,                   // 0xE0 - 0xEF
+  4,                      // 0xF0 - 0xF7
+  0,                      // 0xF8 - 0xFF
+
+};
 
 int ReadUTF8Character(char* text, int* outputCodepoint) {
   /*
    * Read a single UTF-8 character from a string.
    * Stores the character's codepoint in `outputcodepoint`
    * and returns its width in bytes.
+   *
+   * Malformed sequences produce `UTF8_REPLACEMENT_CHARACTER`
+   * and are skipped up to the first byte that doesn't belong
+   * to them, so a terminator is never skipped over.
    */
 
-  int acc = 0;
-  int width = 0;
+  const u8* bytes = (const u8*)text;
+  int acc;
+  int width;
   int i;
 
-  if (*text < 0x80) {
-
-    acc = *text;
-    width = 1;
+  width = sUTF8SequenceLengths[bytes[0] >> 3];
 
-  } else {
+  if (width == 1) {
+    *outputCodepoint = bytes[0];
+    return 1;
+  }
 
-    width = GetUTF8Displacement(*text, 0);
-    acc = *text & (0x7F >> width);
+  if (width == 0) {
+    *outputCodepoint = UTF8_REPLACEMENT_CHARACTER;
+    return 1;
+  }
 
-    for (i = 1; i < width; i++) {
+  acc = bytes[0] & (0x7F >> width);
 
-      acc = (acc << 6) | (text[i] & 0x7F);
+  for (i = 1; i < width; i++) {
 
+    if ((bytes[i] & 0xC0) != 0x80) {
+      *outputCodepoint = UTF8_REPLACEMENT_CHARACTER;
+      return i;
     }
+
+    acc = (acc << 6) | (bytes[i] & 0x3F);
+
   }
 
   *outputCodepoint = acc;
   return width;
 
 }
+
+void StartUTF8Iterator(struct UTF8Iterator* iterator, char* text) {
+  /*
+   * Sets up an iterator to read characters from
+   * a UTF-8 encoded string.
+   */
+
+  iterator->text = (const u8*)text;
+  iterator->asciiCount = 0;
+}
+
+int NextUTF8Character(struct UTF8Iterator* iterator) {
+  /*
+   * Reads the next character's codepoint from a
+   * UTF-8 encoded string. The caller must stop once the
+   * string's terminator has been read.
+   *
+   * Most text is ASCII, so whenever the text is
+   * word-aligned a whole word is read at once. If none
+   * of its bytes have their top bit set, they're all ASCII
+   * and are handed out one at a time without being decoded.
+   * Aligned words never cross into the next word, so this
+   * can't read outside of the terminator's word.
+   */
+
+  u32 word;
+  int codepoint;
+
+  if (iterator->asciiCount != 0) {
+    codepoint = iterator->asciiRun & 0xFF;
+    iterator->asciiRun >>= 8;
+    iterator->asciiCount--;
+    return codepoint;
+  }
+
+  if (((uintptr_t)iterator->text & 3) == 0) {
+
+    word = *(const u32*)iterator->text;
+
+    if ((word & 0x80808080) == 0) {
+      iterator->text += 4;
+      iterator->asciiRun = word >> 8;
+      iterator->asciiCount = 3;
+      return word & 0xFF;
+    }
+
+  }
+
+  iterator->text += ReadUTF8Character((char*)iterator->text, &codepoint);
+
+  return codepoint;
+}
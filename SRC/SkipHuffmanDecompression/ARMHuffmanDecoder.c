@@ -0,0 +1,105 @@
+
+#include "gbafe.h"
+
+/*
+ * This file is compiled as ARM code and copied into IWRAM
+ * by `DecodeHuffmanText`, so everything here has to be in
+ * one function that doesn't call anything else.
+ */
+
+#define HUFFMAN_LOOKUP_BITS 8
+#define HUFFMAN_LEAF_FLAG 0x8000
+
+#define HUFFMAN_ENTRY_USED_MASK 0x0F
+#define HUFFMAN_ENTRY_LENGTH_SHIFT 4
+#define HUFFMAN_ENTRY_END 0x80
+#define HUFFMAN_ENTRY_NODE_SHIFT 16
+
+extern const u16* const gHuffmanTree;
+extern const u32 gHuffmanLookupTable[1 << HUFFMAN_LOOKUP_BITS];
+
+void ARM_DecodeHuffmanText(const char* source, char* dest)
+{
+  /*
+   * Decodes Huffman-compressed text into `dest`, producing the
+   * same text as the vanilla decoder. See
+   * `generate_huffman_table.py` for the table's format.
+   *
+   * Compressed text is read into a buffer of bits a byte
+   * at a time, lowest bit first. This can read a few bytes
+   * past the end of the text, which is harmless in ROM.
+   */
+
+  const u8* src = (const u8*)source;
+  const u16* node;
+  u32 bits = 0;
+  int count = 0;
+  u32 entry;
+  int used;
+  int length;
+
+  for (;;)
+  {
+    while (count <= 24)
+    {
+      bits |= (u32)*src++ << count;
+      count += 8;
+    }
+
+    entry = gHuffmanLookupTable[bits & ((1 << HUFFMAN_LOOKUP_BITS) - 1)];
+    used = entry & HUFFMAN_ENTRY_USED_MASK;
+
+    if (used != 0)
+    {
+
+      // One or more whole characters.
+
+      bits >>= used;
+      count -= used;
+
+      length = (entry >> HUFFMAN_ENTRY_LENGTH_SHIFT) & 3;
+
+      dest[0] = entry >> 8;
+      if (length > 1)
+        dest[1] = entry >> 16;
+      if (length > 2)
+        dest[2] = entry >> 24;
+
+      dest += length;
+
+      if (entry & HUFFMAN_ENTRY_END)
+        return;
+
+      continue;
+    }
+
+    // Characters that take more than 8 bits are finished
+    // one bit at a time.
+
+    bits >>= HUFFMAN_LOOKUP_BITS;
+    count -= HUFFMAN_LOOKUP_BITS;
+
+    node = &gHuffmanTree[(entry >> HUFFMAN_ENTRY_NODE_SHIFT) * 2];
+
+    while (!(node[1] & HUFFMAN_LEAF_FLAG))
+    {
+      if (count == 0)
+      {
+        bits = *src++;
+        count = 8;
+      }
+
+      node = &gHuffmanTree[node[bits & 1] * 2];
+
+      bits >>= 1;
+      count--;
+    }
+
+    *dest++ = node[0];
+    if ((node[0] & 0xFF) == 0)
+      return;
+
+    if ((node[0] >> 8) != 0)
+      *dest++ = node[0] >> 8;
+  }
+}
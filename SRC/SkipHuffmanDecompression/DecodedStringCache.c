@@ -0,0 +1,252 @@
+
+#include "gbafe.h"
+
+void DecodeHuffmanText(const char* source, char* dest);
+
+enum
+{
+  TEXT_END             = 0x00,
+  TEXT_LOAD_PORTRAIT   = 0x10,
+  TEXT_CONTROL_CODE    = 0x80,
+};
+
+#define DECODED_STRING_CACHE_MAX_ENTRIES 32
+#define DECODED_STRING_CACHE_MAGIC 0x53444343 // "CCDS"
+
+struct DecodedStringCacheEntry {
+  /*
+   * A decoded string in the cache's data area.
+   */
+
+  const char* source; /*
+    * The Huffman-compressed text that the string
+    * was decoded from.
+    */
+  u16 offset; /*
+    * Where the string starts in the data area.
+    */
+  u16 length; /*
+    * The number of bytes in the string, including
+    * its terminator.
+    */
+
+};
+
+struct DecodedStringCache {
+  /*
+   * This lives at the start of the decoded string cache's
+   * space in EWRAM, and is followed by the data area that
+   * holds the strings themselves.
+   */
+
+  u32 magic; /*
+    * This is set to `DECODED_STRING_CACHE_MAGIC` once the
+    * cache has been initialized, so that we don't trust
+    * whatever garbage was in RAM before.
+    */
+  u32 hits; /*
+    * The number of times that a requested string was
+    * already decoded.
+    */
+  u32 misses; /*
+    * The number of times that a requested string had
+    * to be decoded.
+    */
+  u16 used; /*
+    * The number of bytes of the data area in use. Strings
+    * are packed together from the start of the data area.
+    */
+  u16 count; /*
+    * The number of entries in use.
+    */
+  struct DecodedStringCacheEntry entries[DECODED_STRING_CACHE_MAX_ENTRIES]; /*
+    * Entries ordered from most recently used to
+    * least recently used.
+    */
+  char data[];
+
+};
+
+extern const u16 gDecodedStringCacheSize;
+extern struct DecodedStringCache* const gDecodedStringCache;
+
+static struct DecodedStringCache* GetDecodedStringCache(void) {
+  /*
+   * Gets the decoded string cache, initializing it if needed.
+   * Returns NULL if there isn't a cache.
+   */
+
+  struct DecodedStringCache* cache;
+
+  if (gDecodedStringCacheSize == 0)
+    return NULL;
+
+  cache = gDecodedStringCache;
+
+  if (cache->magic != DECODED_STRING_CACHE_MAGIC) {
+    cache->used = 0;
+    cache->count = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->magic = DECODED_STRING_CACHE_MAGIC;
+  }
+
+  return cache;
+}
+
+static int GetDecodedStringLength(const char* text) {
+  /*
+   * Gets the length of a decoded string, including its
+   * terminator. Like `RemoveHuffmanPadding`, this skips over
+   * the arguments of text codes, which might be 00.
+   */
+
+  int pos = 0;
+
+  while (text[pos] != TEXT_END)
+  {
+    if (text[pos] == TEXT_LOAD_PORTRAIT)
+      pos += 2;
+
+    else if (text[pos] == TEXT_CONTROL_CODE)
+      pos += 1;
+
+    pos++;
+  }
+
+  return pos + 1;
+}
+
+static void CopyDecodedString(char* dest, const char* source, int length) {
+  int i;
+
+  for (i = 0; i < length; i++)
+    dest[i] = source[i];
+}
+
+static void UseDecodedStringCacheEntry(struct DecodedStringCache* cache, int i) {
+  /*
+   * Moves the `i`th entry in the cache to the front.
+   */
+
+  struct DecodedStringCacheEntry entry;
+
+  entry = cache->entries[i];
+
+  for (; i > 0; i--)
+    cache->entries[i] = cache->entries[i - 1];
+
+  cache->entries[0] = entry;
+}
+
+static void EvictDecodedString(struct DecodedStringCache* cache) {
+  /*
+   * Removes the least recently used string from the cache,
+   * moving the strings after it down to fill its space.
+   */
+
+  struct DecodedStringCacheEntry* evicted;
+  int i;
+
+  cache->count--;
+  evicted = &cache->entries[cache->count];
+
+  CopyDecodedString(
+    &cache->data[evicted->offset],
+    &cache->data[evicted->offset + evicted->length],
+    cache->used - (evicted->offset + evicted->length));
+
+  cache->used -= evicted->length;
+
+  for (i = 0; i < cache->count; i++)
+  {
+    if (cache->entries[i].offset > evicted->offset)
+      cache->entries[i].offset -= evicted->length;
+  }
+}
+
+void DecodeCachedString(const char* source, char* dest) {
+  /*
+   * Decodes Huffman-compressed text into `dest`, or copies
+   * it from the cache if it was decoded recently. Menus
+   * redraw the same item, unit, and help text names over
+   * and over, so this saves a lot of decoding.
+   *
+   * The decompression hook doesn't know the text ID, so
+   * strings are remembered by their compressed text instead,
+   * which is the same thing for anything in the text table.
+   */
+
+  struct DecodedStringCache* cache;
+  struct DecodedStringCacheEntry* entry;
+  int i;
+  int length;
+
+  cache = GetDecodedStringCache();
+
+  if (cache == NULL)
+  {
+    DecodeHuffmanText(source, dest);
+    return;
+  }
+
+  for (i = 0; i < cache->count; i++)
+  {
+    entry = &cache->entries[i];
+
+    if (entry->source != source)
+      continue;
+
+    CopyDecodedString(dest, &cache->data[entry->offset], entry->length);
+
+    cache->hits++;
+    UseDecodedStringCacheEntry(cache, i);
+
+    return;
+  }
+
+  cache->misses++;
+
+  DecodeHuffmanText(source, dest);
+
+  // Strings that wouldn't fit even in an empty cache
+  // would only push everything else out, so they're
+  // left uncached.
+
+  length = GetDecodedStringLength(dest);
+  if (length > gDecodedStringCacheSize)
+    return;
+
+  while ((cache->count == DECODED_STRING_CACHE_MAX_ENTRIES) || ((cache->used + length) > gDecodedStringCacheSize))
+    EvictDecodedString(cache);
+
+  entry = &cache->entries[cache->count];
+
+  entry->source = source;
+  entry->offset = cache->used;
+  entry->length = length;
+
+  CopyDecodedString(&cache->data[cache->used], dest, length);
+
+  cache->used += length;
+  cache->count++;
+
+  UseDecodedStringCacheEntry(cache, cache->count - 1);
+}
+
+void ClearDecodedStringCache(void) {
+  /*
+   * Forgets every string in the cache. Text in the text
+   * table never changes, but code that decodes text from
+   * RAM that it later rewrites should call this first.
+   */
+
+  struct DecodedStringCache* cache;
+
+  cache = GetDecodedStringCache();
+  if (cache == NULL)
+    return;
+
+  cache->used = 0;
+  cache->count = 0;
+}
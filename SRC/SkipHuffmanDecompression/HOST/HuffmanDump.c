@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "gbafe.h"
+
+/*
+ * Decodes every compressed text entry in `HostText.c` using
+ * the table decoder and writes the results to a file, so that
+ * they can be compared against the vanilla decoder's output.
+ * `HostText.c` is written by the `check_huffman_decoder.py`
+ * script.
+ *
+ * Usage: HuffmanDump <output>
+ *
+ * Each entry is decoded into a buffer of `HOST_TEXT_BUFFER_SIZE`
+ * bytes that's filled with `HOST_TEXT_SENTINEL` beforehand, and
+ * the whole buffer is written, so that writes past the end of
+ * the text can be caught.
+ */
+
+#define HOST_TEXT_BUFFER_SIZE 0x1000
+#define HOST_TEXT_SENTINEL 0xAA
+
+extern const u8 gHostText[];
+extern const u32 gHostTextOffsets[];
+extern const u32 gHostTextCount;
+
+void ARM_DecodeHuffmanText(const char* source, char* dest);
+
+int main(int argc, char** argv) {
+
+  static char buffer[HOST_TEXT_BUFFER_SIZE];
+  FILE* output;
+  u32 i;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <output>\n", argv[0]);
+    return 1;
+  }
+
+  if ((output = fopen(argv[1], "wb")) == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  for (i = 0; i < gHostTextCount; i++) {
+    memset(buffer, HOST_TEXT_SENTINEL, sizeof(buffer));
+    ARM_DecodeHuffmanText((const char*)&gHostText[gHostTextOffsets[i]], buffer);
+    fwrite(buffer, 1, sizeof(buffer), output);
+  }
+
+  fclose(output);
+
+  return 0;
+}
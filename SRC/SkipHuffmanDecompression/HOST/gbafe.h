@@ -0,0 +1,18 @@
+#ifndef GUARD_HOST_GBAFE_H
+#define GUARD_HOST_GBAFE_H
+
+/*
+ * This stands in for CLib's `gbafe.h` when building the
+ * table decoder for a PC, see `HuffmanDump.c`. Only the parts
+ * of CLib that the table decoder uses are here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef int32_t  s32;
+
+#endif // GUARD_HOST_GBAFE_H
@@ -0,0 +1,44 @@
+
+#include "gbafe.h"
+
+extern void (*gpARM_HuffmanTextDecomp)(const char *, char *);
+
+#define HUFFMAN_DECODER_MAGIC 0x44484343 // "CCHD"
+
+extern const u32 gARMHuffmanDecoder[];
+extern const u16 gARMHuffmanDecoderSize;
+extern u32* const gHuffmanDecoderRAM;
+
+void DecodeHuffmanText(const char* source, char* dest) {
+  /*
+   * Decodes Huffman-compressed text into `dest` using the
+   * table decoder, or the vanilla decoder if the table decoder
+   * doesn't have any IWRAM to run from.
+   *
+   * The table decoder is copied into IWRAM the first time that
+   * it's needed, after a magic word that says that it's there.
+   * IWRAM isn't cleared on reset, so it's only copied again if
+   * something else has used that space since.
+   */
+
+  u32* ram;
+  int i;
+
+  ram = gHuffmanDecoderRAM;
+
+  if (ram == NULL)
+  {
+    gpARM_HuffmanTextDecomp(source, dest);
+    return;
+  }
+
+  if (ram[0] != HUFFMAN_DECODER_MAGIC)
+  {
+    for (i = 0; i < (gARMHuffmanDecoderSize / 4); i++)
+      ram[i + 1] = gARMHuffmanDecoder[i];
+
+    ram[0] = HUFFMAN_DECODER_MAGIC;
+  }
+
+  ((void (*)(const char*, char*))&ram[1])(source, dest);
+}
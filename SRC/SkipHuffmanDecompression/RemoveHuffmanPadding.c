@@ -0,0 +1,70 @@
+#include "gbafe.h"
+
+enum
+{
+  TEXT_END             = 0x00,
+  TEXT_LOAD_PORTRAIT   = 0x10,
+  TEXT_HUFFMAN_PADDING = 0x1F,
+  TEXT_CONTROL_CODE    = 0x80,
+};
+
+extern char** const gUnpaddedText;
+
+void RemoveHuffmanPadding(char* text) // 0x0800A1C8
+{
+  /*
+   * This function removes Huffman padding characters at
+   * the end of a text entry. This is a lot of work
+   * just to replace one byte, and it's weird that
+   * it just leaves the padding bytes that end up at the
+   * ends of odd-width lines.
+
+   * This is slightly different from the vanilla function,
+   * mostly in that it doesn't use an s16 for the position.
+   * This ends up saving us a lot of space.
+   */
+
+  int pos = 0;
+  char current;
+
+  // Length-prefixed entries never have padding, so
+  // there's nothing to remove from them.
+
+  if (gUnpaddedText != NULL && *gUnpaddedText == text)
+  {
+    *gUnpaddedText = NULL;
+    return;
+  }
+
+  // Vanilla does this to avoid thinking that a 00
+  // within a text code is the text terminator, but
+  // I don't think that's really necessary considering that
+  // other functions like String_CopyTo don't take these
+  // into consideration.
+
+  while (text[pos] != TEXT_END)
+  {
+    current = text[pos];
+
+    if (current == TEXT_LOAD_PORTRAIT)
+      pos += 2;
+
+    else if (current == TEXT_CONTROL_CODE)
+      pos += 1;
+
+    pos++;
+  }
+
+  pos--;
+  while (pos >= 0)
+  {
+
+    if (text[pos] != TEXT_HUFFMAN_PADDING)
+      return;
+
+    if (text[pos - 1] != TEXT_CONTROL_CODE)
+      text[pos] = TEXT_END;
+
+    pos--;
+  }
+}
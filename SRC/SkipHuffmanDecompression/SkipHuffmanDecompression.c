@@ -1,65 +1,38 @@
-
 #include "gbafe.h"
 
-extern void (*gpARM_HuffmanTextDecomp)(const char *, char *);
 void String_CopyTo(char* dest, const char* source);
+void DecodeCachedString(const char* source, char* dest);
 
-enum
-{
-  TEXT_END             = 0x00,
-  TEXT_LOAD_PORTRAIT   = 0x10,
-  TEXT_HUFFMAN_PADDING = 0x1F,
-  TEXT_CONTROL_CODE    = 0x80,
-};
+#define TEXT_UNCOMPRESSED_FLAG    0x80000000
+#define TEXT_LENGTH_PREFIXED_FLAG 0x40000000
 
-void RemoveHuffmanPadding(char* text) // 0x0800A1C8
+extern char** const gUnpaddedText;
+
+static void CopyLengthPrefixedText(const u32* source, char* dest)
 {
   /*
-   * This function removes Huffman padding characters at
-   * the end of a text entry. This is a lot of work
-   * just to replace one byte, and it's weird that
-   * it just leaves the padding bytes that end up at the
-   * ends of odd-width lines.
-
-   * This is slightly different from the vanilla function,
-   * mostly in that it doesn't use an s16 for the position.
-   * This ends up saving us a lot of space.
+   * Length-prefixed entries are a word with the length
+   * of the text, including its terminator, followed by
+   * the text. Knowing the length lets us copy most of
+   * the text a block at a time, instead of a byte at a time.
    */
 
-  int pos = 0;
-  char current;
+  const char* text = (const char*)&source[1];
+  u32 length = source[0];
+  u32 pos = 0;
 
-  // Vanilla does this to avoid thinking that a 00
-  // within a text code is the text terminator, but
-  // I don't think that's really necessary considering that
-  // other functions like String_CopyTo don't take these
-  // into consideration.
-
-  while (text[pos] != TEXT_END)
+  if (((u32)dest & 3) == 0)
   {
-    current = text[pos];
-
-    if (current == TEXT_LOAD_PORTRAIT)
-      pos += 2;
-
-    else if (current == TEXT_CONTROL_CODE)
-      pos += 1;
-
-    pos++;
+    pos = length & ~0x1F;
+    if (pos != 0)
+      CpuFastCopy(text, dest, pos);
   }
 
-  pos--;
-  while (pos >= 0)
-  {
-
-    if (text[pos] != TEXT_HUFFMAN_PADDING)
-      return;
+  for (; pos < length; pos++)
+    dest[pos] = text[pos];
 
-    if (text[pos - 1] != TEXT_CONTROL_CODE)
-      text[pos] = TEXT_END;
-
-    pos--;
-  }
+  if (gUnpaddedText != NULL)
+    *gUnpaddedText = dest;
 }
 
 void HuffmanTextDecompReplacement(const char* source, char* dest) // Original at 0x08002BA4
@@ -69,14 +42,30 @@ void HuffmanTextDecompReplacement(const char* source, char* dest) // Original at
    * bit of our pointer to flag entries as uncompressed,
    * we can just treat the pointer like a signed value
    * and use that to select our copying method.
+   *
+   * Uncompressed entries that also have the next bit set
+   * are length-prefixed, and can be copied more quickly.
+   *
+   * Compressed entries go through the decoded string
+   * cache, which decodes them as normal if it's disabled.
+   * Uncompressed entries are already just a copy.
    */
 
+  if (gUnpaddedText != NULL)
+    *gUnpaddedText = NULL;
+
   if ((s32)source > 0)
-    gpARM_HuffmanTextDecomp(source, dest);
+    DecodeCachedString(source, dest);
+
+  else if ((int)source & TEXT_LENGTH_PREFIXED_FLAG)
+  {
+    source = (const char*)((int)source & (~(TEXT_UNCOMPRESSED_FLAG | TEXT_LENGTH_PREFIXED_FLAG)));
+    CopyLengthPrefixedText((const u32*)source, dest);
+  }
 
   else
   {
-    source = (const char*)((int)source & (~0x80000000));
+    source = (const char*)((int)source & (~TEXT_UNCOMPRESSED_FLAG));
     String_CopyTo(dest, source);
   }
 }
@@ -0,0 +1,35 @@
+
+#include "gbafe.h"
+
+#define TEXT_UNCOMPRESSED_FLAG    0x80000000
+#define TEXT_LENGTH_PREFIXED_FLAG 0x40000000
+
+extern char* const* const* const gTextTablePointer;
+
+char* GetStringPointerFromIndex(int index) {
+  /*
+   * Gets a text entry's text for code that only needs to
+   * read it. Uncompressed entries are returned straight from
+   * ROM without being copied, while compressed entries are
+   * decoded with `GetStringFromIndex` as normal.
+   *
+   * Like with `GetStringFromIndex`, the text of a compressed
+   * entry is only around until the next entry is decoded.
+   * Uncompressed entries also skip `RemoveHuffmanPadding`,
+   * but they don't have any padding to remove.
+   */
+
+  char* text;
+
+  text = (*gTextTablePointer)[index];
+
+  if ((s32)text > 0)
+    return GetStringFromIndex(index);
+
+  // Length-prefixed entries' text comes after their length.
+
+  if ((int)text & TEXT_LENGTH_PREFIXED_FLAG)
+    return (char*)((int)text & (~(TEXT_UNCOMPRESSED_FLAG | TEXT_LENGTH_PREFIXED_FLAG))) + 4;
+
+  return (char*)((int)text & (~TEXT_UNCOMPRESSED_FLAG));
+}
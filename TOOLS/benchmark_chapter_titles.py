@@ -0,0 +1,917 @@
+#!/usr/bin/python3
+
+"""
+Benchmark the chapter title renderer on a PC.
+
+This script builds a chapter title font, converts it into C, compiles
+it along with the Chapter Titles as Text code for the host machine and
+times how long it takes to render a set of chapter titles.
+
+"""
+
+import sys
+import csv
+import re
+import struct
+import hashlib
+import random
+import shutil
+import subprocess
+import tempfile
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+from generate_chapter_title_font import (
+    Error,
+    MAX_CELL_SIZE,
+    MAX_PAGES,
+    PAGE_WIDTH,
+    PAGE_HEIGHT,
+    require_pillow,
+    process_kerning_file,
+    process_whitespace_file,
+    build_kerning_classes,
+    build_index,
+  )
+from render_chapter_titles import (
+    read_font,
+    render_title,
+  )
+
+desc = """Benchmark the chapter title renderer on a PC.
+
+The font is either an existing glyph folder, given with '--font', or a
+synthetic font of '--synthetic' 16x16 pixel glyphs starting at U+4E00, like a
+Japanese or Chinese font would need. Synthetic glyphs are random strokes in
+three colors. With '--sheets', the glyphs are read from a folder of glyph
+sheets instead, along with any other files in the '--font' folder. Any other
+options, like '--glyph-store' or '--binary', are passed along to
+'generate_chapter_title_font.py' when building the font. Without
+'--glyph-store', the font has to fit on its font pages, so synthetic fonts
+are limited to 1024 glyphs; the default of 6000 needs '--glyph-store'.
+
+The chapter titles are '--titles' random strings of '--length' glyphs each,
+picked from the font. Every title is rendered '--rounds' times using
+'--method', and the number of titles and glyphs drawn per second is printed
+along with the number of font pages that were decompressed. The method is
+'load' for 'LoadChapterTitleGfx', 'batch' for 'LoadChapterTitleGfxBatch', or
+a number of glyphs to draw per call to 'ContinueChapterTitleRender'.
+
+The host build has '--cache-slots' font page cache slots and
+'--vram-cache-slots' VRAM cache slots, and '--scratch' and '--render-states'
+give it a scratch surface and render states, like 'ChapterTitleScratchRAM'
+and 'ChapterTitleRenderRAM' would.
+
+The host build uses 'HOST/gbafe.h' in place of CLib and 'HOST/Host.c' in
+place of the vanilla functions that the chapter title code calls. Compressed
+font pages are stored uncompressed on the host, so the time spent
+decompressing pages isn't representative of the GBA, but the number of
+decompressions is.
+
+Timings are for the host machine and are only useful for comparing
+changes to the renderer against each other.
+
+With '--chapter-titles', every entry in 'ChapterTitles.tsv' is rendered
+ahead of the random titles, using the special chapter title table and the
+'TEXT' folder, and the font defaults to the module's 'GLYPHS' folder.
+
+Before timing, each title is rendered once and its 4bpp strip is read back
+out of VRAM. '--check' compares the strips against ones drawn by
+'render_chapter_titles.py', which follows the same layout rules, and
+'--golden' compares them against strips saved by an earlier run with
+'--save-golden'. Golden strips are only comparable between runs with the
+same font and titles.
+
+The entries in 'ChapterTitles.tsv' are also always compared against the
+hashes of their strips in 'HOST/GoldenStrips.tsv' when they're drawn with
+the module's own 'GLYPHS' folder. '--update-golden-hashes' saves the current
+strips' hashes there instead, for when the font or titles are changed on
+purpose.
+
+Whenever strips are compared, they're drawn with every method, both by the
+benchmark's own build and by one with a scratch surface, render states,
+and font page and VRAM cache slots, and each set of strips is compared. Titles
+that don't match are listed by name, and the script fails if there are any.
+
+The number of glyphs, font pages, decompressions, and VRAM uploads for each
+title is averaged and printed along with the timings, and '--stats' saves
+them for each title as a tab-separated file.
+
+"""
+
+CTF_DIR = Path(__file__).resolve().parent.parent.joinpath(
+    "SRC", "ChapterTitlesAsText"
+  )
+
+GOLDEN_HASHES = CTF_DIR.joinpath("HOST", "GoldenStrips.tsv")
+
+SYNTHETIC_START = 0x4E00
+SYNTHETIC_PAGE_GLYPHS = (
+    (PAGE_WIDTH // MAX_CELL_SIZE) * (PAGE_HEIGHT // MAX_CELL_SIZE)
+  )
+
+host_font_text = """
+#include "gbafe.h"
+#include "CTF.h"
+
+/*
+ * This file is generated by `benchmark_chapter_titles.py`.
+ */
+
+{pages}
+
+const u8* gCTFPageImagePointers[] = {{
+{page_pointers}
+  NULL,
+}};
+
+const u8 gCTFGlyphStoreDepth = {depth};
+const u16 gCTFShadeExpansion[256] = {{
+{expansion}
+}};
+
+const u32 gCTFGlyphRecordOffsets[] = {{
+{record_offsets}
+}};
+
+const u8 gCTFGlyphRecords[] __attribute__((aligned(4))) = {{
+{records}
+}};
+
+const struct FontEntry gCTFMetadata[] = {{
+{metadata}
+  {{ .terminator = -1 }},
+}};
+
+const u16 gCTFIndexBlockCount = {block_count};
+const u16 gCTFIndexBlocks[] = {{ {index_blocks} }};
+const u16 gCTFIndex[] = {{ {index_entries} }};
+
+const u8 gCTFKerningRightClassCount = {right_class_count};
+const s8 gCTFKerningMatrix[] = {{ {kerning_matrix} }};
+
+const struct ChapterTitleGlyphPart gCTFCompositeParts[] = {{
+{composite_parts}
+}};
+
+static u32 sHostPageCache[(0x2C + ({cache_slots} * CTF_PAGE_SIZE)) / 4];
+
+const u8 gCTFPageCacheSlotCount = {cache_slots};
+struct ChapterTitleFontPageCache* const gCTFPageCache = (void*)sHostPageCache;
+
+static u32 sHostVRAMCache[(0x14 + ({vram_cache_slots} * 8)) / 4];
+
+const u8 gChapterTitleVRAMCacheSlotCount = {vram_cache_slots};
+struct ChapterTitleVRAMCache* const gChapterTitleVRAMCache = (void*)sHostVRAMCache;
+
+u32 gHostScratch[CHAPTER_TITLE_STRIP_SIZE / 4];
+struct ChapterTitleRender gHostRenders[CHAPTER_TITLE_BATCH_SIZE];
+
+u32* const gChapterTitleScratch = {scratch};
+struct ChapterTitleRender* const gChapterTitleRenders = {renders};
+
+struct ChapterTitlePalette gChapterTitleTextPalettes[6];
+
+char* gHostTitleText[] = {{
+{title_text}
+}};
+
+const struct ChapterTitleEntry gChapterTitles[] = {{
+{title_entries}
+}};
+
+const u16 gChapterTitleEntryCount = {title_count};
+
+const u8 gDefaultChapterTitleID = 0;
+const u8 gNoDataChapterTitleID = 0;
+const u8 gCreatureCampaignChapterTitleID = 0;
+const u8 gEpilogueChapterTitleID = 0;
+const u8 gSkirmishStartingChapterTitleID = 0;
+
+char* gSpecialChapterTitles[] = {{ NULL }};
+
+const u8 gChapterTitleStripsEnabled = 0;
+const u8* gSpecialChapterTitleStrips[] = {{ NULL }};
+
+const u8 gChapterTitleStreamsEnabled = 0;
+const struct ChapterTitleStream* gSpecialChapterTitleStreams[] = {{ NULL }};
+"""
+
+metadata_template = (
+    "  {{ .codepoint = 0x{codepoint:06X}, .width = {width}, "
+    ".cellWidthFlag = {wide}, .upperMargin = {upper}, "
+    ".lowerMargin = {lower}, .page = {page}, .tile = {tile}, "
+    ".leftKerningClass = {left}, .rightKerningClass = {right}, "
+    ".composite = {composite} }},"
+  )
+
+golden_header = ["Title", "SHA1"]
+
+check_methods = ["load", "batch", "1", "5"]
+
+special_label_pattern = re.compile(r"g(?P<name>\w+)ChapterTitle")
+special_entry_pattern = re.compile(r"SpecialChapterTitle\((?P<special>\w+)\)")
+
+
+def c_array(values, per_line=16):
+  """Format a list of numbers for a C array initializer."""
+  return ",\n".join([
+      "  " + ", ".join([str(v) for v in values[i:i + per_line]])
+      for i in range(0, len(values), per_line)
+    ])
+
+
+def c_string(text):
+  """Format UTF-8 text as a C string literal."""
+  return '"' + "".join([f"\\x{b:02X}" for b in text.encode("UTF-8")]) + '"'
+
+
+def make_synthetic_glyphs(Image, folder, count, seed):
+  """Draw `count` random 16x16 glyphs into a folder."""
+  rng = random.Random(seed)
+
+  palette = []
+  for shade in range(16):
+    palette.extend([shade * 17] * 3)
+
+  for i in range(count):
+
+    glyph = Image.new("P", (16, 16))
+    glyph.putpalette(palette)
+    pixels = glyph.load()
+
+    for _ in range(rng.randint(3, 8)):
+
+      color = rng.randint(1, 3)
+      fixed = rng.randrange(1, 15)
+      start = rng.randrange(0, 8)
+      end = rng.randrange(start + 2, 16)
+
+      for t in range(start, end):
+        if rng.random() < 0.5:
+          pixels[t, fixed] = color
+        else:
+          pixels[fixed, t] = color
+
+    glyph.save(folder.joinpath(f"{SYNTHETIC_START + i:06X}.png"))
+
+
+def make_titles(codepoints, count, length, seed):
+  """Make random chapter titles out of the font's glyphs."""
+  rng = random.Random(seed)
+
+  return [
+      (
+        f"Random{i}",
+        "".join([chr(rng.choice(codepoints)) for _ in range(length)]),
+      )
+      for i in range(count)
+    ]
+
+
+def read_tsv(table):
+  """Read a tab-separated table's rows, without its header."""
+  with table.open("r", encoding="UTF-8") as t:
+    rows = [row for row in csv.reader(t, dialect=csv.excel_tab) if row]
+
+  return rows[1:]
+
+
+def read_chapter_titles(ctf_dir):
+  """
+  Get the name and text of each entry in the chapter title table.
+
+  Entries are resolved through the special chapter title table to
+  the text files that `render_chapter_titles.py` would use. Entries
+  without a text file are skipped.
+  """
+  special = {}
+  for name, label in read_tsv(ctf_dir.joinpath("SpecialChapterTitles.tsv")):
+    match = special_label_pattern.fullmatch(label.strip())
+    if match is not None:
+      special[name.strip()] = match.group("name")
+
+  titles = []
+  for name, index in read_tsv(ctf_dir.joinpath("ChapterTitles.tsv")):
+
+    match = special_entry_pattern.fullmatch(index.strip())
+    if match is None:
+      continue
+
+    text_name = special.get(match.group("special"))
+    if text_name is None:
+      continue
+
+    text_file = ctf_dir.joinpath("TEXT", f"{text_name}.txt")
+    if text_file.exists():
+      titles.append((name.strip(), text_file.read_text(encoding="UTF-8")))
+
+  return titles
+
+
+def read_metadata(folder):
+  """Read the generated metadata file's rows."""
+  with folder.joinpath("CTF_Generated_Metadata.tsv").open("r") as m:
+    rows = [row for row in csv.reader(m, dialect=csv.excel_tab) if row]
+
+  return rows[1:]
+
+
+def get_tile_words(image):
+  """Convert an image into 4bpp tiles as words."""
+  pixels = image.load()
+
+  words = []
+  for tile_y in range(image.height // 8):
+    for tile_x in range(image.width // 8):
+      for y in range(8):
+
+        word = 0
+        for x in range(8):
+          word |= (pixels[(tile_x * 8) + x, (tile_y * 8) + y] & 0xF) << (4 * x)
+
+        words.append(word)
+
+  return words
+
+
+def get_tile_bytes(image):
+  """Convert an image into 4bpp tiles as bytes."""
+  return b"".join([
+      word.to_bytes(4, "little") for word in get_tile_words(image)
+    ])
+
+
+def render_reference_strips(Image, folder, sheets, titles):
+  """Render chapter titles with `render_chapter_titles.py`."""
+  glyphs, kerning, whitespace, composites = read_font(folder, sheets)
+  palette = next(iter(glyphs.values()))[0].getpalette()
+
+  return b"".join([
+      get_tile_bytes(
+          render_title(
+              Image, text, glyphs, kerning, whitespace, composites, palette
+            )
+        )
+      for _, text in titles
+    ])
+
+
+def compare_strips(expected, actual, titles):
+  """Get the names of titles whose strips don't match."""
+  if len(expected) != len(actual):
+    raise Error(
+        f"Expected {len(expected) // STRIP_BYTES} chapter title strips, "
+        f"got {len(actual) // STRIP_BYTES}."
+      )
+
+  return [
+      name
+      for i, (name, _) in enumerate(titles)
+      if (
+          expected[i * STRIP_BYTES:(i + 1) * STRIP_BYTES] !=
+          actual[i * STRIP_BYTES:(i + 1) * STRIP_BYTES]
+        )
+    ]
+
+
+def hash_strips(strips, titles):
+  """Get the hash of each title's strip."""
+  return [
+      hashlib.sha1(strips[i * STRIP_BYTES:(i + 1) * STRIP_BYTES]).hexdigest()
+      for i in range(len(titles))
+    ]
+
+
+def read_golden_hashes(filename):
+  """Read the golden strip hash of each title."""
+  return {name: sha1 for name, sha1 in read_tsv(filename)}
+
+
+def write_golden_hashes(filename, strips, titles):
+  """Save the hash of each title's strip."""
+  with filename.open("w", newline="") as o:
+    writer = csv.writer(o, dialect=csv.excel_tab, lineterminator="\n")
+    writer.writerow(golden_header)
+    for (name, _), sha1 in zip(titles, hash_strips(strips, titles)):
+      writer.writerow([name, sha1])
+
+
+def compare_hashes(golden, strips, titles):
+  """Get the names of titles whose strips don't match their hashes."""
+  return [
+      name
+      for (name, _), sha1 in zip(titles, hash_strips(strips, titles))
+      if golden.get(name) != sha1
+    ]
+
+
+def report_mismatches(source, mismatches, titles):
+  """Print titles that don't match, returning whether they all did."""
+  print(
+      f"{len(titles) - len(mismatches)} of {len(titles)} chapter titles "
+      f"match {source}"
+    )
+
+  for name in mismatches:
+    print(f"  {name} does not match")
+
+  return not mismatches
+
+
+def report_stats(stats_file):
+  """Print the average and largest per-title operation counts."""
+  with stats_file.open("r") as s:
+    rows = [row for row in csv.DictReader(s, dialect=csv.excel_tab)]
+
+  if not rows:
+    return
+
+  print("Per title, average (largest):")
+
+  for column in ("Glyphs", "Pages", "Decompressions", "Uploads"):
+    values = [int(row[column]) for row in rows]
+    print(
+        f"  {column.lower()}: {sum(values) / len(values):.2f} "
+        f"({max(values)})"
+      )
+
+
+def read_installer_data(filename, labels):
+  """
+  Assemble the data after each label in a generated installer
+  that starts with one of `labels`.
+
+  Only the directives that the font generator uses for data
+  are understood, and anything else is skipped. Returns the
+  data for each label, in the order they appear.
+  """
+  sections = {}
+  data = None
+
+  for line in filename.read_text().splitlines():
+    for statement in line.split("//")[0].split(";"):
+
+      tokens = statement.split()
+      if not tokens:
+        continue
+
+      if tokens[0] == "ALIGN":
+        if data is not None:
+          data.extend(bytes(-len(data) % int(tokens[1], 0)))
+
+      elif (len(tokens) == 1) and tokens[0].endswith(":"):
+        label = tokens[0][:-1]
+        data = None
+        if label.startswith(labels):
+          data = sections.setdefault(label, bytearray())
+
+      elif data is None:
+        continue
+
+      elif tokens[0] == "#incbin":
+        binary = filename.parent.joinpath(statement.split('"')[1])
+        data.extend(binary.read_bytes())
+
+      elif tokens[0] in directive_sizes:
+        size = directive_sizes[tokens[0]]
+        for value in tokens[1:]:
+          value = int(value.strip("()"), 0) % (1 << (8 * size))
+          data.extend(value.to_bytes(size, "little"))
+
+  return sections
+
+
+class HostConfig:
+  """The optional buffers that a host build of the renderer has."""
+
+  def __init__(self, cache_slots, vram_cache_slots, scratch, render_states):
+    self.cache_slots = cache_slots
+    self.vram_cache_slots = vram_cache_slots
+    self.scratch = scratch
+    self.render_states = render_states
+
+  def describe(self):
+    """Describe the build's buffers."""
+    buffers = [
+        f"{self.cache_slots} page cache slots",
+        f"{self.vram_cache_slots} VRAM cache slots",
+      ]
+    if self.scratch:
+      buffers.append("scratch")
+    if self.render_states:
+      buffers.append("render states")
+
+    return ", ".join(buffers)
+
+
+def build_host_font(Image, folder, titles, config, filename):
+  """Convert a generated font and some chapter titles into C."""
+  rows = read_metadata(folder)
+  codepoints = dict.fromkeys([int(row[1], 16) for row in rows])
+
+  kerning = {}
+  if (kf := folder.joinpath("Kerning.txt")).exists():
+    kerning = process_kerning_file(kf)
+
+  whitespace = {}
+  if (wf := folder.joinpath("Whitespace.txt")).exists():
+    whitespace = process_whitespace_file(wf)
+
+  _, _, matrix = build_kerning_classes(codepoints, kerning)
+  blocks, index = build_index(codepoints, whitespace)
+
+  metadata = "\n".join([
+      metadata_template.format(
+          codepoint=int(codepoint, 16),
+          width=int(width) & 0x1F,
+          wide=1 if (wide == "True") else 0,
+          upper=upper,
+          lower=lower,
+          page=page,
+          tile=tile,
+          left=left,
+          composite=composite,
+          right=right,
+        )
+      for (
+          _, codepoint, width, wide, upper, lower, page, tile,
+          left, right, composite,
+        ) in rows
+    ])
+
+  # The composite glyph part table is only in the installer.
+
+  installer = read_installer_data(
+      folder.joinpath("CTF_Generated_Installer.event"),
+      ("gCTFCompositeParts",)
+    )
+
+  composite_parts = ",\n".join([
+      f"  {{ {glyph}, {x}, {y} }}"
+      for glyph, x, y in struct.iter_unpack("<Hbb", installer["gCTFCompositeParts"])
+    ])
+
+  page_files = sorted(folder.glob("CTF_Generated_Page_*.png"))
+  pages = "\n".join([
+      f"static const u32 sPage{i:02d}[] = {{\n  {CTF_PAGE_BYTES},\n"
+      f"{c_array(get_tile_words(Image.open(page_file)), 8)}\n}};"
+      for i, page_file in enumerate(page_files)
+    ])
+
+  # Glyph records follow the record table, each under
+  # its own label when they aren't in a binary file.
+
+  glyph_store = read_installer_data(
+      folder.joinpath("CTF_Generated_Glyphs.event"),
+      ("gCTFGlyphStoreDepth", "gCTFShadeExpansion", "gCTFGlyphRecord", "CTF_Glyph_")
+    )
+
+  depth = glyph_store["gCTFGlyphStoreDepth"][0]
+  expansion = [
+      e for e, in struct.iter_unpack("<H", glyph_store["gCTFShadeExpansion"])
+    ]
+  offsets = [
+      o for o, in struct.iter_unpack("<I", glyph_store["gCTFGlyphRecordOffsets"])
+    ]
+  records = b"".join([
+      data for label, data in glyph_store.items()
+      if label.startswith(("gCTFGlyphRecords", "CTF_Glyph_"))
+    ])
+
+  host_font = host_font_text.format(
+      pages=pages,
+      page_pointers="\n".join([
+          f"  (const u8*)sPage{i:02d}," for i in range(len(page_files))
+        ]),
+      depth=depth,
+      expansion=c_array(expansion or [0]),
+      record_offsets=c_array(offsets or [0], 8),
+      records=c_array(list(records) or [0]),
+      metadata=metadata,
+      block_count=len(blocks),
+      index_blocks=", ".join([str(b) for b in blocks]),
+      index_entries=", ".join([str(e) for e in index]),
+      right_class_count=len(matrix[0]),
+      kerning_matrix=", ".join([str(a) for row in matrix for a in row]),
+      composite_parts=composite_parts,
+      cache_slots=config.cache_slots,
+      vram_cache_slots=config.vram_cache_slots,
+      scratch="gHostScratch" if config.scratch else "NULL",
+      renders="gHostRenders" if config.render_states else "NULL",
+      title_text=",\n".join([f"  {c_string(text)}" for _, text in titles]),
+      title_entries=",\n".join([
+          f"  {{ .textID = {i} }}" for i in range(len(titles))
+        ]),
+      title_count=len(titles),
+    )
+
+  with filename.open("w") as o:
+    o.write(host_font)
+
+
+def build_benchmark(Image, folder, titles, config, cc, name, temp):
+  """Build the benchmark for a host config, returning its path."""
+  host_font = temp.joinpath(f"{name}Font.c")
+  build_host_font(Image, folder, titles, config, host_font)
+
+  benchmark = temp.joinpath(name)
+
+  subprocess.run(
+      [
+        cc, "-O2", "-Wall",
+        "-I", CTF_DIR.joinpath("HOST"),
+        "-I", CTF_DIR.joinpath("SRC"),
+        "-o", benchmark,
+        CTF_DIR.joinpath("HOST", "Benchmark.c"),
+        CTF_DIR.joinpath("HOST", "Host.c"),
+        host_font,
+        *sorted(CTF_DIR.joinpath("SRC").glob("*.c")),
+      ],
+      check=True,
+    )
+
+  return benchmark
+
+
+CTF_PAGE_BYTES = 256 * 32
+STRIP_BYTES = 32 * 2 * 32
+
+directive_sizes = {"BYTE": 1, "SHORT": 2, "WORD": 4}
+
+
+def main():
+  """Build and run the chapter title benchmark."""
+  Image = require_pillow()
+
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "--font",
+      type=Path,
+      help="A folder that contains glyph images."
+    )
+  parser.add_argument(
+      "--synthetic",
+      type=int,
+      default=6000,
+      help="The number of glyphs in the synthetic font."
+    )
+  parser.add_argument(
+      "--titles",
+      type=int,
+      default=1000,
+      help="The number of chapter titles to render."
+    )
+  parser.add_argument(
+      "--length",
+      type=int,
+      default=12,
+      help="The number of glyphs in each chapter title."
+    )
+  parser.add_argument(
+      "--rounds",
+      type=int,
+      default=20,
+      help="The number of times to render each chapter title."
+    )
+  parser.add_argument(
+      "--cache-slots",
+      type=int,
+      default=0,
+      help="The number of font page cache slots."
+    )
+  parser.add_argument(
+      "--vram-cache-slots",
+      type=int,
+      default=0,
+      help="The number of VRAM cache slots."
+    )
+  parser.add_argument(
+      "--scratch",
+      action="store_true",
+      help="Draw titles into a scratch surface."
+    )
+  parser.add_argument(
+      "--render-states",
+      action="store_true",
+      help="Keep render states in RAM rather than on the stack."
+    )
+  parser.add_argument(
+      "--method",
+      default="load",
+      help="How to draw the titles: 'load', 'batch', or glyphs per call."
+    )
+  parser.add_argument(
+      "--seed",
+      type=int,
+      default=0,
+      help="The seed for the synthetic font and chapter titles."
+    )
+  parser.add_argument(
+      "--cc",
+      default="cc",
+      help="The host C compiler."
+    )
+  parser.add_argument(
+      "--sheets",
+      type=Path,
+      help="Read the font's glyphs from a folder of glyph sheets."
+    )
+  parser.add_argument(
+      "--chapter-titles",
+      action="store_true",
+      help="Also render every entry in the chapter title table."
+    )
+  parser.add_argument(
+      "--check",
+      action="store_true",
+      help="Compare strips against 'render_chapter_titles.py'."
+    )
+  parser.add_argument(
+      "--golden",
+      type=Path,
+      help="Compare strips against a file saved with '--save-golden'."
+    )
+  parser.add_argument(
+      "--save-golden",
+      type=Path,
+      help="Save the rendered strips to a file."
+    )
+  parser.add_argument(
+      "--update-golden-hashes",
+      action="store_true",
+      help="Save the chapter title table's strip hashes."
+    )
+  parser.add_argument(
+      "--stats",
+      type=Path,
+      help="Save the per-title operation counts to a file."
+    )
+
+  args, generator_args = parser.parse_known_args()
+
+  if args.chapter_titles and (args.font is None):
+    args.font = CTF_DIR.joinpath("GLYPHS")
+
+  # Synthetic glyphs are 16x16, so only so many of
+  # them are guaranteed to fit on the font pages.
+
+  synthetic_limit = MAX_PAGES * SYNTHETIC_PAGE_GLYPHS
+
+  if (args.font is None) and ("--glyph-store" not in generator_args) \
+      and (args.synthetic > synthetic_limit):
+    raise Error(
+        f"A synthetic font of {args.synthetic} glyphs doesn't fit on "
+        f"{MAX_PAGES} font pages. Use '--glyph-store', or a '--synthetic' "
+        f"of at most {synthetic_limit}."
+      )
+
+  titles = read_chapter_titles(CTF_DIR) if args.chapter_titles else []
+
+  # Golden hashes are for the module's own font.
+
+  golden_titles = []
+  if (args.font is not None) and (args.sheets is None) \
+      and (args.font.resolve() == CTF_DIR.joinpath("GLYPHS")):
+    golden_titles = list(titles)
+
+  if args.update_golden_hashes and not golden_titles:
+    raise Error(
+        "Golden hashes are only for '--chapter-titles' drawn with the "
+        "module's 'GLYPHS' folder."
+      )
+
+  golden = {}
+  if golden_titles and not args.update_golden_hashes:
+    golden = read_golden_hashes(GOLDEN_HASHES)
+
+  config = HostConfig(
+      args.cache_slots, args.vram_cache_slots,
+      args.scratch, args.render_states,
+    )
+
+  if (len(titles) + args.titles) > 0x7FFF:
+    raise Error(
+        "Cannot have more than 32767 chapter titles."
+      )
+
+  with tempfile.TemporaryDirectory() as temp:
+
+    temp = Path(temp)
+    folder = temp.joinpath("GLYPHS")
+    folder.mkdir()
+
+    if args.font is not None:
+      for f in args.font.iterdir():
+        if f.is_file() and not f.name.startswith("CTF_Generated_"):
+          shutil.copy(f, folder)
+    else:
+      make_synthetic_glyphs(Image, folder, args.synthetic, args.seed)
+
+    subprocess.run(
+        [
+          sys.executable,
+          Path(__file__).resolve().parent.joinpath(
+              "generate_chapter_title_font.py"
+            ),
+          folder,
+          *(["--sheets", args.sheets] if (args.sheets is not None) else []),
+          *generator_args,
+        ],
+        check=True,
+      )
+
+    codepoints = [int(row[1], 16) for row in read_metadata(folder)]
+    titles.extend(
+        make_titles(codepoints, args.titles, args.length, args.seed)
+      )
+
+    benchmark = build_benchmark(
+        Image, folder, titles, config, args.cc, "Benchmark", temp
+      )
+
+    strips_file = temp.joinpath("Strips.4bpp")
+    stats_file = temp.joinpath("Stats.tsv")
+
+    subprocess.run(
+        [benchmark, str(args.rounds), strips_file, stats_file, args.method],
+        check=True,
+      )
+
+    report_stats(stats_file)
+
+    if args.save_golden is not None:
+      shutil.copy(strips_file, args.save_golden)
+
+    if args.update_golden_hashes:
+      write_golden_hashes(GOLDEN_HASHES, strips_file.read_bytes(), golden_titles)
+
+    if args.stats is not None:
+      shutil.copy(stats_file, args.stats)
+
+    references = []
+
+    if args.check:
+      references.append((
+          "render_chapter_titles.py",
+          render_reference_strips(Image, folder, args.sheets, titles),
+        ))
+
+    if args.golden is not None:
+      references.append((args.golden.name, args.golden.read_bytes()))
+
+    # Every method is checked with the benchmark's own build
+    # and with one that has every optional buffer.
+
+    builds = []
+
+    if references or golden:
+
+      full = HostConfig(
+          max(args.cache_slots, 1), max(args.vram_cache_slots, 4),
+          True, True,
+        )
+
+      builds = [
+          (config, benchmark),
+          (full, build_benchmark(
+              Image, folder, titles, full, args.cc, "BenchmarkFull", temp
+            )),
+        ]
+
+    methods = list(dict.fromkeys(check_methods + [args.method]))
+    matched = True
+
+    for check_config, check in builds:
+      for method in methods:
+
+        subprocess.run(
+            [check, "0", strips_file, "-", method],
+            check=True,
+          )
+
+        strips = strips_file.read_bytes()
+        run = f"'{method}' with {check_config.describe()}"
+
+        for source, reference in references:
+          matched &= report_mismatches(
+              f"{source} ({run})",
+              compare_strips(reference, strips, titles),
+              titles,
+            )
+
+        if golden:
+          matched &= report_mismatches(
+              f"{GOLDEN_HASHES.name} ({run})",
+              compare_hashes(golden, strips, golden_titles),
+              golden_titles,
+            )
+
+  return 0 if matched else 1
+
+
+if __name__ == "__main__":
+  sys.exit(main())
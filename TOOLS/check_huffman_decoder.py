@@ -0,0 +1,230 @@
+#!/usr/bin/python3
+
+"""
+Check the Huffman table decoder against the vanilla decoder on a PC.
+
+This script decodes every compressed text entry in a ROM using the table
+decoder, compiled for the host machine, and compares the results against
+decoding the entries one bit at a time, like the vanilla decoder.
+
+"""
+
+import sys
+import subprocess
+import tempfile
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+from generate_huffman_table import (
+    Error,
+    HuffmanTree,
+    ROM_BASE,
+    UNCOMPRESSED_FLAG,
+    read_rom,
+    read_text_table,
+    add_tree_arguments,
+    add_text_table_arguments,
+    build_lookup_table,
+    decode_reference,
+  )
+
+desc = """Check the Huffman table decoder against the vanilla decoder.
+
+The Huffman tree is read out of the ROM and turned into a lookup table just
+like 'generate_huffman_table.py' does when building. Every compressed entry in
+the text table is then decoded by 'ARMHuffmanDecoder.c', compiled for the host
+machine along with 'HOST/HuffmanDump.c', and one bit at a time by this
+script, which follows the vanilla decoder. Entries whose text doesn't match,
+or where the table decoder writes past the end of the text, are listed by text
+ID, and the script fails if there are any.
+
+'--text-table' is the ROM offset of the pointer to the text table, and the
+defaults for it and for '--tree' and '--root' are for FE8U. The text table is
+read until the first entry that isn't a ROM pointer, unless '--count' is given.
+Entries with their uppermost bit set aren't compressed and are skipped.
+
+"""
+
+HUFFMAN_DIR = Path(__file__).resolve().parent.parent.joinpath(
+    "SRC", "SkipHuffmanDecompression"
+  )
+
+HOST_TEXT_BUFFER_SIZE = 0x1000
+HOST_TEXT_SENTINEL = 0xAA
+
+# The table decoder reads up to this many bytes
+# past the end of the compressed text.
+READ_AHEAD = 4
+
+host_text_text = """
+#include "gbafe.h"
+
+/*
+ * This file is generated by `check_huffman_decoder.py`.
+ */
+
+static const u16 sHostHuffmanTree[] = {{
+{tree}
+}};
+
+const u16* const gHuffmanTree = sHostHuffmanTree;
+
+const u32 gHuffmanLookupTable[] = {{
+{table}
+}};
+
+const u8 gHostText[] = {{
+{text}
+}};
+
+const u32 gHostTextOffsets[] = {{
+{offsets}
+}};
+
+const u32 gHostTextCount = {count};
+"""
+
+
+def c_array(values, per_line=16):
+  """Format a list of values as the body of a C array."""
+  return "\n".join([
+      "  " + " ".join([f"{value}," for value in values[i:i + per_line]])
+      for i in range(0, len(values), per_line)
+    ]) or "  0,"
+
+
+def get_tree_nodes(tree):
+  """Get every node of the tree up to the last one that's reachable."""
+  last = tree.root_index
+  pending = [tree.root_index]
+
+  while pending:
+    node = pending.pop()
+    last = max(last, node)
+    if not tree.is_leaf(node):
+      pending.extend([tree.child(node, 0), tree.child(node, 1)])
+
+  return [
+      value
+      for node in range(last + 1)
+      for value in tree.node(node)
+    ]
+
+
+def build_host_text(tree, rom, entries, filename):
+  """
+  Build the C file of the tree, lookup table, and compressed
+  text for the host decoder. Returns the reference text
+  for each entry.
+  """
+  text = bytearray()
+  offsets = []
+  expected = []
+
+  for text_id, address in entries:
+    decoded, length = decode_reference(tree, rom, address)
+    start = address - ROM_BASE
+
+    offsets.append(len(text))
+    text += rom[start:start + length + READ_AHEAD]
+    expected.append(decoded)
+
+  host_text = host_text_text.format(
+      tree=c_array([f"0x{value:04X}" for value in get_tree_nodes(tree)]),
+      table=c_array([f"0x{entry:08X}" for entry in build_lookup_table(tree)], 8),
+      text=c_array([f"0x{byte:02X}" for byte in text]),
+      offsets=c_array([str(offset) for offset in offsets]),
+      count=len(entries),
+    )
+
+  with filename.open("w") as o:
+    o.write(host_text)
+
+  return expected
+
+
+def compare_text(expected, actual, entries):
+  """Get the text IDs of entries that the table decoder got wrong."""
+  mismatches = []
+
+  for i, (text_id, _) in enumerate(entries):
+    buffer = actual[i * HOST_TEXT_BUFFER_SIZE:(i + 1) * HOST_TEXT_BUFFER_SIZE]
+    text = expected[i]
+
+    if (buffer[:len(text)] != text) or \
+        any(byte != HOST_TEXT_SENTINEL for byte in buffer[len(text):]):
+      mismatches.append(text_id)
+
+  return mismatches
+
+
+def main():
+  """Build and run the Huffman table decoder check."""
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "rom",
+      type=Path,
+      help="The base ROM."
+    )
+  add_tree_arguments(parser)
+  add_text_table_arguments(parser)
+  parser.add_argument(
+      "--cc",
+      default="cc",
+      help="The host C compiler."
+    )
+
+  args = parser.parse_args()
+
+  rom = read_rom(args.rom)
+  tree = HuffmanTree(rom, args.tree, args.root)
+  entries = [
+      (text_id, pointer)
+      for text_id, pointer in read_text_table(rom, args.text_table, args.count)
+      if not (pointer & UNCOMPRESSED_FLAG)
+    ]
+
+  with tempfile.TemporaryDirectory() as temp:
+
+    temp = Path(temp)
+    host_text = temp.joinpath("HostText.c")
+    expected = build_host_text(tree, rom, entries, host_text)
+
+    dump = temp.joinpath("HuffmanDump")
+
+    subprocess.run(
+        [
+          args.cc, "-O2", "-Wall",
+          "-I", HUFFMAN_DIR.joinpath("HOST"),
+          "-o", dump,
+          HUFFMAN_DIR.joinpath("HOST", "HuffmanDump.c"),
+          HUFFMAN_DIR.joinpath("ARMHuffmanDecoder.c"),
+          host_text,
+        ],
+        check=True,
+      )
+
+    dump_file = temp.joinpath("Text.bin")
+    subprocess.run([dump, dump_file], check=True)
+
+    mismatches = compare_text(expected, dump_file.read_bytes(), entries)
+
+  print(
+      f"{len(entries) - len(mismatches)} of {len(entries)} compressed "
+      "text entries match the vanilla decoder."
+    )
+
+  if mismatches:
+    print(
+        "Mismatched text IDs: "
+        + ", ".join([f"0x{text_id:04X}" for text_id in mismatches])
+      )
+
+  return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/python3
+
+"""
+Convert a ROM's uncompressed text entries into length-prefixed entries.
+
+This script reads the text table out of a ROM and writes an installer that
+reinserts every uncompressed entry with its length in front of it, and points
+the text table at the new entries.
+
+"""
+
+import sys
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+from generate_huffman_table import (
+    Error,
+    ROM_BASE,
+    UNCOMPRESSED_FLAG,
+    LENGTH_PREFIXED_FLAG,
+    read_rom,
+    read_text_table,
+    read_text_table_offset,
+    add_text_table_arguments,
+  )
+
+desc = """Convert uncompressed text entries into length-prefixed entries.
+
+With Skip Huffman Decompression, text table entries with the uppermost bit of
+their pointers set are uncompressed and end with a 00 byte. Entries that also
+have the next bit set are length-prefixed: they start with a word that holds
+the length of their text in bytes, including the 00, followed by the text.
+These are copied in blocks rather than a byte at a time, and don't need the
+Huffman padding pass afterward.
+
+This script reads the text table out of a ROM, such as one that's already had
+its text inserted, and writes an installer that contains a length-prefixed copy
+of every uncompressed entry and points the text table at the copies. Include
+the installer after Skip Huffman Decompression and after your text. The old
+entries are left where they are.
+
+'--text-table' is the ROM offset of the pointer to the text table, and its
+default is for FE8U. The installer writes to the table wherever that pointer
+points in the ROM that was read, so the table has to stay there. The text
+table is read until the first entry that isn't a ROM pointer, unless '--count'
+is given. Compressed and already length-prefixed entries are skipped.
+
+"""
+
+installer_header = """
+// This file is generated by `convert_raw_text.py`.
+"""
+
+entry_template = """
+ALIGN 4; {label}_0x{text_id:04X}:
+{text}
+PUSH; ORG 0x{offset:08X}; WORD ({label}_0x{text_id:04X} + 0x{flags:08X}); POP
+"""
+
+length_template = "  WORD {length}\n"
+
+byte_template = "  BYTE {values}"
+
+
+def read_raw_text(rom, address):
+  """Read an uncompressed entry's text, including its terminator."""
+  offset = address - ROM_BASE
+  end = rom.find(b"\0", offset)
+
+  if end == -1:
+    raise Error(f"Text at 0x{address:08X} runs off the end of the ROM.")
+
+  return rom[offset:end + 1]
+
+
+def format_entry(table, text_id, text, length_prefixed):
+  """
+  Format an uncompressed entry and the pointer to it in
+  the text table at ROM offset `table`, optionally
+  length-prefixed.
+  """
+  flags = ROM_BASE | UNCOMPRESSED_FLAG
+
+  if length_prefixed:
+    flags |= LENGTH_PREFIXED_FLAG
+
+  return entry_template.format(
+      label="LengthPrefixedText" if length_prefixed else "RawText",
+      text_id=text_id,
+      text=(length_template.format(length=len(text)) if length_prefixed else "")
+        + "\n".join([
+            byte_template.format(
+                values=" ".join([f"0x{byte:02X}" for byte in text[i:i + 16]])
+              )
+            for i in range(0, len(text), 16)
+          ]),
+      offset=table + (text_id * 4),
+      flags=flags,
+    )
+
+
+def build_installer(rom, table, entries, filename):
+  """
+  Build the installer of length-prefixed entries. Returns
+  the number of entries that were converted.
+  """
+  converted = []
+
+  for text_id, pointer in entries:
+
+    if not (pointer & UNCOMPRESSED_FLAG) or (pointer & LENGTH_PREFIXED_FLAG):
+      continue
+
+    text = read_raw_text(rom, pointer & ~UNCOMPRESSED_FLAG)
+
+    converted.append(format_entry(table, text_id, text, True))
+
+  with filename.open("w") as o:
+    o.write(installer_header + "".join(converted))
+
+  return len(converted)
+
+
+def main():
+  """Convert uncompressed text entries."""
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "rom",
+      type=Path,
+      help="The ROM to read text from."
+    )
+  parser.add_argument(
+      "output",
+      type=Path,
+      help="The installer file to write."
+    )
+  add_text_table_arguments(parser)
+
+  args = parser.parse_args()
+
+  rom = read_rom(args.rom)
+  table = read_text_table_offset(rom, args.text_table)
+  entries = read_text_table(rom, args.text_table, args.count)
+
+  count = build_installer(rom, table, entries, args.output)
+  print(f"Converted {count} of {len(entries)} text entries.")
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
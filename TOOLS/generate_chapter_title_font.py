@@ -12,9 +12,14 @@ metadata file containing information about each glyph.
 
 import sys
 import re
+import struct
+import unicodedata
+from io import BytesIO
 from pathlib import Path
 from argparse import ArgumentParser, RawTextHelpFormatter
 from itertools import islice
+from collections import Counter
+import heapq
 
 desc = """Convert glyph images into a chapter title font.
 
@@ -48,10 +53,8 @@ Instead of codepoints, you may optionally use the character itself, surrounded
 by single quotes. For instance: "'A' 'V' -2".
 
 The outputs produced will be a set of images containing all of the glyphs,
-a metadata file containing information about each glyph, a whitespace
-metadata file containing information about whitespace characters, a kerning
-metadata file containing kerning information, and an installer file that links
-everything together.
+a metadata file containing information about each glyph, and an installer file
+that links everything together.
 
 The font glyphs are sliced into images containing the glyphs in order of
 their codepoints. These images need to be converted into binaries and then
@@ -62,21 +65,95 @@ The metadata file is a tab-separated table that contains the glyph's codepoint,
 width in pixels, whether the glyph's cell is 8 or 16 pixels wide,
 upper margin (the distance between the top of the cell and the highest pixel of
 the glyph), lower margin (the distance between the top of the cell and the
-lowest pixel of the glyph), font page, and kerning information.
-
-The whitespace metadata file is a tab-separated table that contains the
-whitespace character's codepoint and width in pixels.
-
-The installer expects that the metadata and whitespace metadata files
-be converted into files readable by Event Assembler by some other tool. It
-also expects that you create a palette binary from the first generated font
-page image, containing all 12 text color palettes.
-
-The kerning metadata file is an Event Assembler syntax file that consists of
-groups of kerning information. Each group begins with a label that is named
-after the left-side character and is followed by one or more macros that
-contain the right-side character's codepoint and the adjustment value for
-the pair. After the right-side macros, the list is terminated with a -1 word.
+lowest pixel of the glyph), font page, tile, kerning classes, and the position
+of its parts in the composite glyph table.
+
+The installer also contains an index that maps codepoints to glyphs. The
+index is split into blocks of 256 codepoints: a block table that has an entry
+for every block up to the font's highest codepoint, and the blocks themselves,
+which only exist for blocks that contain at least one glyph. Each block entry
+is either a glyph's index in the metadata table, a whitespace character's
+width with the uppermost bit set, or 0xFFFF if the codepoint isn't in the font.
+Whitespace characters are only stored in the index.
+
+Kerning pairs are collapsed into classes: glyphs that kern the same way
+against every right-side glyph share a left-side class, and glyphs that kern
+the same way against every left-side class share a right-side class. Class 0
+on either side never kerns. The installer contains a matrix of signed byte
+adjustments with a row for each left-side class and a column for each
+right-side class.
+
+Glyphs that are made up of other glyphs, like accented letters, can be stored
+as composite glyphs, which are drawn in-game by drawing each of their parts
+and have no graphics of their own. A glyph becomes a composite glyph
+automatically if its character decomposes into a base character and
+combining marks (for example, 'À' into 'A' and U+0300 COMBINING GRAVE ACCENT)
+that all have glyphs in the font, and the parts can be placed so that they
+exactly recreate the glyph's image. Composite glyphs can also be listed in an
+optional file named 'Composites.txt' in the folder. Each line should be
+'<codepoint> <part> <x> <y>[ <part> <x> <y>...]', where each part is a glyph
+and its offset in pixels from the composite glyph's position. As with
+kerning, characters may be used instead of codepoints, and offsets may be
+negative. For example, "'Ä' 'A' 0 0 000308 1 -3". Listed composite glyphs
+don't need images; without one, the composite glyph is as wide as its first
+part. The number of composite glyphs and the tiles that they save are printed
+when there are any. The installer contains a table of each composite glyph's
+parts, with the metadata file giving the position of a glyph's first part in
+the table, or 0 if the glyph isn't a composite glyph.
+
+By default, glyphs are packed into font pages in codepoint order. If one or
+more '--corpus' paths are given, glyphs are instead grouped by how often they
+appear in the same chapter title, so that each title needs as few font pages
+as possible. A corpus path can be a folder, where every .txt file in it is a
+single chapter title, such as the Chapter Titles as Text 'TEXT' folder, or a
+UTF-8 text file with one chapter title per line, such as a dump of the game's
+chapter title text entries. Glyphs that don't appear in the corpus are packed
+last, in codepoint order. The number of font pages that each title needs with
+and without grouping is printed when packing with a corpus.
+
+With '--glyph-store', glyphs aren't packed into compressed font pages at all.
+Instead, each glyph is stored uncompressed as its own record, which can be
+drawn straight from ROM without decompressing anything. A record contains
+the rows of the glyph between its upper and lower margins, with each row
+split into 8 pixel slices and pixels past the glyph's width cleared. If the
+font uses 3 or fewer colors besides transparency, records are stored at 2bpp
+and the installer includes a table that expands 2bpp pixels back into the
+font's colors. Otherwise they're stored at 4bpp. No font page images are
+created in this mode.
+
+With '--subset', only glyphs that appear in the corpus are put into the font.
+Glyphs that are needed by chapter titles that aren't in the corpus, such as
+titles that are put together in-game, can be kept by listing them in an
+optional file named 'Keep.txt' in the folder. Each line of the file should be
+a codepoint, a range of codepoints like '<first codepoint>-<last codepoint>',
+or a character surrounded by single quotes, like "'A'". The dropped glyphs and
+the space that they would have used are printed when subsetting.
+
+Large fonts, such as ones with thousands of Chinese or Japanese glyphs, can be
+built much faster using '--sheets', which requires numpy, and '--binary'.
+
+With '--sheets', glyphs are read straight from a folder of glyph sheets
+instead of from glyph images, without slicing the sheets first. Sheets are
+read just like 'slice_glyphs.py' reads them: each sheet is named after the
+codepoint of its top-left cell, is made of 16x16 pixel cells that go
+left-to-right, top-to-bottom, and blank cells are skipped. Every cell's
+margins and width are measured at once. Glyph images in the folder aren't
+read in this mode, so widths and margins can't be given in filenames.
+
+With '--binary', the metadata, codepoint index, kerning matrix, composite
+glyph parts, and glyph records are written as binary files named
+'CTF_Generated_<Table>.bin' that the installer '#incbin's, rather than as
+Event Assembler code, which Event Assembler is much slower to assemble. The
+metadata file is still written for other tools to read, but doesn't need
+to be converted.
+
+Font page images that already exist with the same contents aren't rewritten,
+so that build tools that go by modification times don't recompress them.
+
+The installer expects that the metadata file be converted into a file readable
+by Event Assembler by some other tool. It also expects that you create a
+palette binary from the first generated font page image, containing all 12
+text color palettes.
 
 The installer file is an Event Assembler syntax file that is '#include'ed by
 the Chapter Titles as Text EA installer, and shouldn't be '#include'ed by user
@@ -86,9 +163,23 @@ code.
 
 MIN_CELL_SIZE = 8
 MAX_CELL_SIZE = 16
-MAX_PAGE_TILES = 256
 MAX_PAGES = 16
 
+# See `CTF.h`.
+METADATA_ENTRY_SIZE = 12
+PAGE_SIZE = 256 * 32
+
+PAGE_WIDTH = 256
+PAGE_HEIGHT = 64
+
+INDEX_BLOCK_SHIFT = 8
+INDEX_BLOCK_SIZE = 1 << INDEX_BLOCK_SHIFT
+INDEX_MISSING = 0xFFFF
+INDEX_WHITESPACE = 0x8000
+MAX_GLYPHS = INDEX_WHITESPACE
+
+MAX_KERNING_CLASSES = 256
+
 valid_cell_sizes = range(MIN_CELL_SIZE, MAX_CELL_SIZE + 8, 8)
 
 
@@ -110,6 +201,28 @@ kerning_line_pattern = re.compile(r"""
     \s+(?P<adjustment>-?[0-9a-fA-F]+)
   """, re.VERBOSE)
 
+keep_line_pattern = re.compile(r"""
+    (?:'(?P<character>[^\'])'
+    |(?P<first_codepoint>[0-9a-fA-F]+)(?:\s*-\s*(?P<last_codepoint>[0-9a-fA-F]+))?)
+  """, re.VERBOSE)
+
+composite_part_pattern = r"(?:'[^\']'|[0-9a-fA-F]+)"
+
+composite_line_pattern = re.compile(rf"""
+    (?P<composite>{composite_part_pattern})
+    (?P<parts>(?:\s+{composite_part_pattern}\s+-?[0-9a-fA-F]+\s+-?[0-9a-fA-F]+)+)
+  """, re.VERBOSE)
+
+composite_parts_pattern = re.compile(rf"""
+    (?P<part>{composite_part_pattern})
+    \s+(?P<x>-?[0-9a-fA-F]+)
+    \s+(?P<y>-?[0-9a-fA-F]+)
+  """, re.VERBOSE)
+
+sheet_file_pattern = re.compile(r"(?P<codepoint>[0-9a-fA-F]+)\.png")
+
+page_file_pattern = re.compile(r"CTF_Generated_Page_(?P<page>[0-9]+)\.png")
+
 whitespace_line_pattern = re.compile(r"""
     (?P<codepoint>[0-9a-fA-F]+)
     \s+(?P<width>[0-9a-fA-F]+)
@@ -142,50 +255,88 @@ ALIGN 4; gChapterTitleTextPalettes:
 #endif // __DEBUG
 
 ALIGN 4; gCTFMetadata:
-  #include "CTF_Generated_Metadata.tsv.event"
+  {metadata}
   WORD (-1)
 
 #ifdef __DEBUG
   MESSAGE Chapter Title Font Metadata gCTFMetadata to CURRENTOFFSET
 #endif // __DEBUG
 
-ALIGN 4; gCTFLookup:
-{lookup_entries}
-  WORD (-1)
+ALIGN 4; gCTFIndexBlockCount:
+  SHORT {block_count}
+
+ALIGN 4; gCTFIndexBlocks:
+{index_blocks}
+
+ALIGN 4; gCTFIndex:
+{index_entries}
 
 #ifdef __DEBUG
-  MESSAGE Chapter Title Font Lookup gCTFLookup to CURRENTOFFSET
+  MESSAGE Chapter Title Font Index gCTFIndexBlockCount to CURRENTOFFSET
 #endif // __DEBUG
 
-ALIGN 4; gCTFWhitespace:
-{whitespace}
-  WORD (-1)
+ALIGN 4; gCTFKerningRightClassCount:
+  BYTE {right_class_count}
+
+ALIGN 4; gCTFKerningMatrix:
+{kerning_matrix}
 
 #ifdef __DEBUG
-  MESSAGE Chapter Title Font Whitespace gCTFWhitespace to CURRENTOFFSET
+  MESSAGE Chapter Title Font Kerning gCTFKerningRightClassCount to CURRENTOFFSET
 #endif // __DEBUG
 
-ALIGN 4; gCTFKerning:
-{kerning}
-  WORD (-1)
+ALIGN 4; gCTFCompositeParts:
+{composite_parts}
 
 #ifdef __DEBUG
-  MESSAGE Chapter Title Font Kerning gCTFKerning to CURRENTOFFSET
+  MESSAGE Chapter Title Font Composite Glyphs gCTFCompositeParts to CURRENTOFFSET
 #endif // __DEBUG
 
+#include "CTF_Generated_Glyphs.event"
+
 """
 
-whitespace_installer_text = \
-  '  #include "CTF_Generated_Whitespace.tsv.event"'
-kerning_installer_text = \
-  '  #include "CTF_Generated_Kerning.event"'
+glyph_store_text = """
+ALIGN 4; gCTFGlyphStoreDepth:
+  BYTE {depth}
+
+ALIGN 4; gCTFShadeExpansion:
+{expansion}
+
+ALIGN 4; gCTFGlyphRecordOffsets:
+{record_offsets}
+
+ALIGN 4; gCTFGlyphRecords:
+{records}
+
+#ifdef __DEBUG
+  MESSAGE Chapter Title Font Glyph Records gCTFGlyphRecordOffsets to CURRENTOFFSET
+#endif // __DEBUG
+"""
+
+no_glyph_store_text = """
+ALIGN 4; gCTFGlyphStoreDepth:
+  BYTE 0
+
+gCTFShadeExpansion:
+gCTFGlyphRecordOffsets:
+gCTFGlyphRecords:
+"""
+
+glyph_record_template = """ALIGN 4; CTF_Glyph_{codepoint:06X}:
+{slices}"""
 
 page_pointer_template = "  POIN gCTFGeneratedPage{page:02d}"
 page_inclusion_template = """
 ALIGN 4; gCTFGeneratedPage{page:02d}:
 #incbin "CTF_Generated_Page_{page:02d}.4bpp.lz77"
 """
-lookup_template = "  ChapterTitleLookupEntry(0x{glyph:06X}, CTF_{glyph:06X})"
+index_template = "  SHORT {entries}"
+offset_template = "  WORD {entries}"
+metadata_inclusion = '#include "CTF_Generated_Metadata.tsv.event"'
+binary_inclusion_template = '#incbin "CTF_Generated_{table}.bin"'
+kerning_row_template = "  BYTE {entries}"
+composite_part_template = "  SHORT 0x{glyph:04X}; BYTE 0x{x:02X} 0x{y:02X}"
 
 
 def batched(iterable, n):
@@ -229,9 +380,11 @@ def process_kerning_file(filename):
     adjustment = int(match.group("adjustment"), 16)
 
     if left_codepoint not in kerning:
-      kerning[left_codepoint] = []
+      kerning[left_codepoint] = {}
+
+    # Like the old per-glyph lists, the first definition of a pair wins.
 
-    kerning[left_codepoint].append((right_codepoint, adjustment))
+    kerning[left_codepoint].setdefault(right_codepoint, adjustment)
 
   return kerning
 
@@ -261,7 +414,331 @@ def process_whitespace_file(filename):
   return whitespace
 
 
-def build_metadata_file(metadata, kerning, filename):
+def parse_character(text):
+  """Parse a codepoint or a character surrounded by single quotes."""
+  if text.startswith("'"):
+    return ord(text[1])
+
+  return int(text, 16)
+
+
+def process_composites_file(filename):
+  """Parse composite glyph definitions into a dict."""
+  composites = {}
+  with filename.open("r", encoding="UTF-8") as c:
+    raw_composite_lines = [
+        l_ for l_ in c.readlines()
+        if l_.strip()
+      ]
+
+  for line in raw_composite_lines:
+    match = composite_line_pattern.fullmatch(line.strip())
+
+    if match is None:
+      raise Error(
+          f"Unable to parse composite glyph definition: '{line}'."
+        )
+
+    composite_codepoint = parse_character(match.group("composite"))
+
+    composites[composite_codepoint] = [
+        (
+          parse_character(part.group("part")),
+          int(part.group("x"), 16),
+          int(part.group("y"), 16),
+        )
+        for part in composite_parts_pattern.finditer(match.group("parts"))
+      ]
+
+  return composites
+
+
+def process_keep_file(filename):
+  """Parse a list of glyphs to keep when subsetting into a set."""
+  keep = set()
+  with filename.open("r", encoding="UTF-8") as k:
+    raw_keep_lines = [
+        l_ for l_ in k.readlines()
+        if l_.strip()
+      ]
+
+  for line in raw_keep_lines:
+    match = keep_line_pattern.match(line.strip())
+
+    if match is None:
+      raise Error(
+          f"Unable to parse glyph to keep: '{line}'."
+        )
+
+    if (c := match.group("character")) is not None:
+      keep.add(ord(c))
+      continue
+
+    first = int(match.group("first_codepoint"), 16)
+    last = first
+    if (lc := match.group("last_codepoint")) is not None:
+      last = int(lc, 16)
+
+    keep.update(range(first, last + 1))
+
+  return keep
+
+
+def build_kerning_classes(metadata, kerning):
+  """
+  Collapse kerning pairs into left- and right-side classes.
+
+  Returns dicts that map codepoints to their left- and right-side
+  classes and the class pair adjustment matrix, as a list of rows.
+  """
+  # Glyphs with identical rows of adjustments share a left-side class.
+
+  rows = {}
+  for left, pairs in kerning.items():
+    if left not in metadata:
+      continue
+    row = tuple(sorted(
+        (right, adjustment) for right, adjustment in pairs.items()
+        if (right in metadata) and (adjustment != 0)
+      ))
+    if row:
+      rows[left] = row
+
+  left_rows = [()]
+  left_classes = {}
+  for left, row in rows.items():
+    if row not in left_rows:
+      left_rows.append(row)
+    left_classes[left] = left_rows.index(row)
+
+  # Glyphs with identical columns of adjustments across the
+  # left-side classes share a right-side class.
+
+  rights = sorted({right for row in left_rows for right, _ in row})
+
+  right_columns = [tuple([0] * len(left_rows))]
+  right_classes = {}
+  for right in rights:
+    column = tuple(dict(row).get(right, 0) for row in left_rows)
+    if column not in right_columns:
+      right_columns.append(column)
+    right_classes[right] = right_columns.index(column)
+
+  if max(len(left_rows), len(right_columns)) > MAX_KERNING_CLASSES:
+    raise Error(
+        f"Cannot have more than {MAX_KERNING_CLASSES} kerning classes."
+      )
+
+  matrix = [
+      [column[i] for column in right_columns]
+      for i in range(len(left_rows))
+    ]
+
+  return left_classes, right_classes, matrix
+
+
+def get_glyph_pixels(glyph):
+  """
+  Get the pixels of a glyph that are drawn in-game, as a dict
+  that maps (x, y) positions to colors.
+  """
+  glyph_image, glyph_width, upper, lower = glyph
+  pixels = glyph_image.load()
+
+  return {
+      (x, y): pixels[x, y] & 0xF
+      for y in range(upper, lower)
+      for x in range(min(glyph_width, glyph_image.width))
+      if pixels[x, y] & 0xF
+    }
+
+
+def match_composite(glyphs, codepoint, part_codepoints):
+  """
+  Try to recreate a glyph's image using other glyphs.
+
+  Each part is placed wherever it changes the most pixels that
+  the previous parts have drawn, without drawing any pixels or
+  colors that the glyph doesn't have. Returns a list of (codepoint, x, y) parts, or
+  None if the parts don't exactly recreate the glyph.
+  """
+  target = get_glyph_pixels(glyphs[codepoint])
+  composed = {}
+  parts = []
+
+  for part in part_codepoints:
+
+    pixels = get_glyph_pixels(glyphs[part])
+    if not pixels:
+      return None
+
+    # Some pixel of the part has to land on the part's
+    # first pixel, which narrows down where it can go.
+
+    first_x, first_y = min(pixels, key=lambda p: (p[1], p[0]))
+    offsets = {(0, 0)} | {(x - first_x, y - first_y) for x, y in target}
+
+    best = None
+
+    for dx, dy in offsets:
+
+      moved = {(x + dx, y + dy): c for (x, y), c in pixels.items()}
+
+      if any((target.get(p, 0) & c) != c for p, c in moved.items()):
+        continue
+
+      changed = [
+          p for p, c in moved.items()
+          if (composed.get(p, 0) | c) != composed.get(p, 0)
+        ]
+
+      score = (len(changed), -(abs(dx) + abs(dy)))
+
+      if (best is None) or (score > best[0]):
+        best = (score, dx, dy, moved)
+
+    if best is None:
+      return None
+
+    (new_pixels, _), dx, dy, moved = best
+
+    # Parts that wouldn't change anything aren't needed.
+
+    if new_pixels == 0:
+      continue
+
+    for p, c in moved.items():
+      composed[p] = composed.get(p, 0) | c
+
+    parts.append((part, dx, dy))
+
+  return parts if (composed == target) else None
+
+
+def compose_glyph(Image, glyphs, parts):
+  """Draw a composite glyph that doesn't have an image of its own."""
+  base_image, base_width, _, _ = glyphs[parts[0][0]]
+
+  glyph_image = Image.new("P", base_image.size)
+  glyph_image.putpalette(base_image.getpalette())
+  pixels = glyph_image.load()
+
+  for part, dx, dy in parts:
+    for (x, y), c in get_glyph_pixels(glyphs[part]).items():
+      if (0 <= (x + dx) < glyph_image.width) and (0 <= (y + dy) < glyph_image.height):
+        pixels[x + dx, y + dy] |= c
+
+  upper, lower = 0, 0
+  if (glyph_bbox := glyph_image.getbbox()) is not None:
+    _, upper, _, lower = glyph_bbox
+
+  return (glyph_image, base_width, upper, lower)
+
+
+def find_composites(Image, glyphs, explicit):
+  """
+  Find glyphs that can be drawn using other glyphs.
+
+  Glyphs in `explicit` are always composite glyphs, and ones that
+  don't have images are added to `glyphs`. Other glyphs are composite
+  glyphs if their characters decompose into characters that are all
+  in the font and those glyphs exactly recreate their images.
+
+  Returns a dict that maps composite glyphs' codepoints to lists
+  of their parts as (codepoint, x, y) tuples.
+  """
+  composites = {}
+
+  for codepoint, parts in explicit.items():
+    for part, x, y in parts:
+
+      if part not in glyphs:
+        raise Error(
+            f"Composite glyph '{codepoint:06X}' uses '{part:06X}', "
+            "which isn't in the font."
+          )
+
+      if part in explicit:
+        raise Error(
+            f"Composite glyph '{codepoint:06X}' uses '{part:06X}', "
+            "which is also a composite glyph."
+          )
+
+      if not ((-128 <= x <= 127) and (-128 <= y <= 127)):
+        raise Error(
+            f"Composite glyph '{codepoint:06X}' has part '{part:06X}' "
+            f"too far away at ({x}, {y})."
+          )
+
+    composites[codepoint] = parts
+
+  for codepoint, parts in composites.items():
+    if codepoint not in glyphs:
+      glyphs[codepoint] = compose_glyph(Image, glyphs, parts)
+
+  explicit_parts = {part for parts in explicit.values() for part, _, _ in parts}
+
+  for codepoint in glyphs:
+
+    if (codepoint in composites) or (codepoint in explicit_parts):
+      continue
+
+    if codepoint > sys.maxunicode:
+      continue
+
+    decomposition = [
+        ord(c) for c in unicodedata.normalize("NFD", chr(codepoint))
+      ]
+
+    if len(decomposition) < 2:
+      continue
+
+    if not all((c in glyphs) and (c not in composites) for c in decomposition):
+      continue
+
+    if (parts := match_composite(glyphs, codepoint, decomposition)) is not None:
+      composites[codepoint] = parts
+
+  return composites
+
+
+def expand_composites(codepoints, composites):
+  """Replace composite glyphs in a set of codepoints with their parts."""
+  return {
+      part
+      for c in codepoints
+      for part in ([p for p, _, _ in composites[c]] if c in composites else [c])
+    }
+
+
+def build_composite_parts(metadata, composites):
+  """
+  Build the composite glyph part table.
+
+  Returns a dict that maps composite glyphs to the position of
+  their first part in the table, and the table itself as a list
+  of (glyph index, x, y) tuples. The table starts with an empty
+  list of parts so that 0 can mean that a glyph isn't composite.
+  """
+  indices = {codepoint: i for i, codepoint in enumerate(metadata.keys())}
+
+  terminator = (INDEX_MISSING, 0, 0)
+  table = [terminator]
+  starts = {}
+
+  for codepoint, parts in composites.items():
+
+    if codepoint not in metadata:
+      continue
+
+    starts[codepoint] = len(table)
+    table.extend([(indices[part], x, y) for part, x, y in parts])
+    table.append(terminator)
+
+  return starts, table
+
+
+def build_metadata_file(metadata, kerning_classes, composite_starts, filename):
   """Construct the metadata file from the metadata."""
   metadata_lines = [
       "\t".join([
@@ -273,10 +750,14 @@ def build_metadata_file(metadata, kerning, filename):
           "LowerMargin",
           "Page",
           "Tile",
-          "Kerning",
+          "LeftKerningClass",
+          "RightKerningClass",
+          "Composite",
         ])
     ]
 
+  left_classes, right_classes, _ = kerning_classes
+
   for glyph, (width, flag, upper, lower, page, tile) in metadata.items():
 
     line = "\t".join([
@@ -288,7 +769,9 @@ def build_metadata_file(metadata, kerning, filename):
         f"{lower:d}",
         f"{page:d}",
         f"{tile:d}",
-        f"CTF_Kerning_{glyph:06X}" if glyph in kerning else "NoKerning",
+        f"{left_classes.get(glyph, 0):d}",
+        f"{right_classes.get(glyph, 0):d}",
+        f"{composite_starts.get(glyph, 0):d}",
       ])
     metadata_lines.append(line)
 
@@ -298,48 +781,94 @@ def build_metadata_file(metadata, kerning, filename):
     o.write("\n".join(metadata_lines))
 
 
-def build_whitespace_file(whitespace, filename):
-  """Construct the whitespace file from the whitespace data."""
-  whitespace_lines = [
-      "\t".join([
-          "ChapterTitleWhitespaceEntry()",
-          "Codepoint",
-          "Width",
-        ])
-    ]
+def build_metadata_binary(metadata, kerning_classes, composite_starts):
+  """Pack the metadata into `FontEntry`s, without a terminator."""
+  left_classes, right_classes, _ = kerning_classes
+
+  return b"".join([
+      struct.pack(
+          "<IBBBBBBH",
+          glyph | ((width & 0x1F) << 24) | ((1 if flag else 0) << 29),
+          upper,
+          lower,
+          page,
+          tile,
+          left_classes.get(glyph, 0),
+          right_classes.get(glyph, 0),
+          composite_starts.get(glyph, 0),
+        )
+      for glyph, (width, flag, upper, lower, page, tile) in metadata.items()
+    ])
 
-  for character, width in whitespace.items():
 
-    line = "\t".join([
-        f"CTF_Whitespace_{character:06X}",
-        f"0x{character:06X}",
-        f"{width:d}"
-      ])
-    whitespace_lines.append(line)
+def write_binary(folder, table, data):
+  """
+  Write a table as a binary file, returning the
+  installer line that includes it.
+  """
+  folder.joinpath(f"CTF_Generated_{table}.bin").write_bytes(data)
 
-  whitespace_lines.append("")
+  return binary_inclusion_template.format(table=table)
 
-  with filename.open("w") as o:
-    o.write("\n".join(whitespace_lines))
 
+def build_index(metadata, whitespace):
+  """
+  Build the codepoint index.
+
+  Returns the block table and a flat list of the
+  entries of every block that's used.
+  """
+  entries = {
+      codepoint: i
+      for i, codepoint in enumerate(metadata.keys())
+    }
+  entries.update({
+      codepoint: INDEX_WHITESPACE | width
+      for codepoint, width in whitespace.items()
+    })
+
+  if len(metadata) > MAX_GLYPHS:
+    raise Error(
+        f"Cannot index more than {MAX_GLYPHS} glyphs, got {len(metadata)}."
+      )
+
+  block_count = (max(entries.keys()) >> INDEX_BLOCK_SHIFT) + 1
+
+  blocks = [INDEX_MISSING] * block_count
+  index = []
+
+  for codepoint in sorted(entries.keys()):
 
-def build_kerning_file(kerning, filename):
-  """Construct the kerning file from the kerning data."""
-  kerning_lines = ["\n"]
-  for left, right_list in kerning.items():
-    kerning_lines.append(f"ALIGN 4; CTF_Kerning_{left:06X}:\n")
-    for right, adjustment in right_list:
-      kerning_lines.append(
-          f"ChapterTitleKerningEntry(0x{right:06X}, {adjustment:d})\n"
+    block = codepoint >> INDEX_BLOCK_SHIFT
+
+    if blocks[block] == INDEX_MISSING:
+      blocks[block] = len(index) >> INDEX_BLOCK_SHIFT
+      index.extend([INDEX_MISSING] * INDEX_BLOCK_SIZE)
+
+    index[(blocks[block] << INDEX_BLOCK_SHIFT) | (codepoint & 0xFF)] = \
+      entries[codepoint]
+
+  return blocks, index
+
+
+def format_shorts(values, per_line=16):
+  """Format a list of values as lines of `SHORT`s."""
+  return "\n".join([
+      index_template.format(
+          entries=" ".join([f"0x{value:04X}" for value in batch])
         )
-    kerning_lines.append("WORD (-1)\n\n")
+      for batch in batched(values, per_line)
+    ])
 
-  with filename.open("w") as o:
-    o.writelines(kerning_lines)
 
+def build_installer(metadata, whitespace, kerning_classes, composites, pagecount, filename, binary):
+  """
+  Build the final installer file. `composites` is the
+  composite glyph starts and part table, and when `binary`
+  is set, tables are written as binary files.
+  """
+  composite_starts, composite_parts = composites
 
-def build_installer(metadata, whitespace, kerning, pagecount, filename):
-  """Build the final installer file."""
   page_pointers = "\n".join([
       page_pointer_template.format(page=i)
       for i in range(pagecount)
@@ -348,27 +877,70 @@ def build_installer(metadata, whitespace, kerning, pagecount, filename):
       page_inclusion_template.format(page=i)
       for i in range(pagecount)
     ])
-  lookup_entries = "\n".join([
-      lookup_template.format(glyph=chunk[0])
-      for chunk in batched(metadata.keys(), 32)
-    ])
-  whitespace = whitespace_installer_text if whitespace else ""
-  kerning = kerning_installer_text if kerning else ""
+  blocks, index = build_index(metadata, whitespace)
+  _, _, matrix = kerning_classes
+
+  if binary:
+
+    folder = filename.parent
+
+    tables = {
+        "metadata": write_binary(
+            folder,
+            "Metadata",
+            build_metadata_binary(metadata, kerning_classes, composite_starts)
+          ),
+        "index_blocks": write_binary(
+            folder, "IndexBlocks", struct.pack(f"<{len(blocks)}H", *blocks)
+          ),
+        "index_entries": write_binary(
+            folder, "Index", struct.pack(f"<{len(index)}H", *index)
+          ),
+        "kerning_matrix": write_binary(
+            folder, "Kerning", bytes([a & 0xFF for row in matrix for a in row])
+          ),
+        "composite_parts": write_binary(
+            folder,
+            "Composites",
+            b"".join([struct.pack("<Hbb", *part) for part in composite_parts])
+          ),
+      }
+
+  else:
+
+    tables = {
+        "metadata": metadata_inclusion,
+        "index_blocks": format_shorts(blocks),
+        "index_entries": format_shorts(index),
+        "kerning_matrix": "\n".join([
+            kerning_row_template.format(
+                entries=" ".join([f"0x{(a & 0xFF):02X}" for a in batch])
+              )
+            for row in matrix
+            for batch in batched(row, 16)
+          ]),
+        "composite_parts": "\n".join([
+            composite_part_template.format(
+                glyph=glyph, x=(x & 0xFF), y=(y & 0xFF)
+              )
+            for glyph, x, y in composite_parts
+          ]),
+      }
 
   installer = installer_text.format(
       page_pointers=page_pointers,
       page_inclusions=page_inclusions,
-      lookup_entries=lookup_entries,
-      whitespace=whitespace,
-      kerning=kerning,
+      block_count=len(blocks),
+      right_class_count=len(matrix[0]),
+      **tables,
     )
 
   with filename.open("w") as o:
     o.write(installer)
 
 
-def main():
-  """Process glyphs into sheets and metadata."""
+def require_pillow():
+  """Import Pillow's Image module or complain about it."""
   try:
     from PIL import Image
   except ImportError:
@@ -376,6 +948,565 @@ def main():
         "This script requires Pillow. See: "
         "https://pillow.readthedocs.io/en/stable/installation.html"
       )
+  return Image
+
+
+def require_numpy():
+  """Import numpy or complain about it."""
+  try:
+    import numpy
+  except ImportError:
+    raise Error(
+        "Reading glyph sheets requires numpy. See: "
+        "https://numpy.org/install/"
+      )
+  return numpy
+
+
+def find_glyph_files(folder):
+  """Get all of the glyph images in a folder, in codepoint order."""
+  glyph_files = sorted([
+      f for f in folder.glob("*.png")
+      if glyph_file_pattern.match(str(f.name)) is not None
+    ])
+
+  if not glyph_files:
+    raise Error(
+        f"Could not find any glyph files in folder."
+      )
+
+  return glyph_files
+
+
+def read_glyph(Image, glyph_file):
+  """
+  Open a glyph image and get its metadata.
+
+  Returns the glyph's codepoint, image, width, upper margin, and
+  lower margin. Values specified in the glyph's filename override
+  the ones that are measured from the image.
+  """
+  glyph_image = Image.open(glyph_file)
+
+  if glyph_image.mode != "P":
+    raise Error(
+        f"Glyph image '{glyph_file}' must be an indexed image."
+      )
+
+  if (h := glyph_image.height) != 16:
+    raise Error(
+        f"Glyph image '{glyph_file}' must have a height of 16 pixels, "
+        f"got {h}."
+      )
+
+  if (w := glyph_image.width) not in valid_cell_sizes:
+    raise Error(
+        f"Glyph image '{glyph_file}' must have a width in pixels of "
+        f"one of {list(valid_cell_sizes)}, got {w}."
+      )
+
+  match = glyph_file_pattern.match(str(glyph_file.name))
+  glyph_codepoint = int(match.group("codepoint"), base=16)
+
+  glyph_bbox = glyph_image.getbbox()
+  _, glyph_upper_margin, glyph_width, glyph_lower_margin = glyph_bbox
+
+  if (mw := match.group("width")) is not None:
+    glyph_width = int(mw, 16)
+
+  if (mu := match.group("upper_margin")) is not None:
+    glyph_upper_margin = int(mu, 16)
+
+  if (ml := match.group("lower_margin")) is not None:
+    glyph_lower_margin = int(ml, 16)
+
+  return (
+      glyph_codepoint,
+      glyph_image,
+      glyph_width,
+      glyph_upper_margin,
+      glyph_lower_margin,
+    )
+
+
+def read_sheets(Image, numpy, folder):
+  """
+  Read every glyph from a folder of glyph sheets.
+
+  Returns a dict of each glyph's image, width, upper margin,
+  and lower margin by codepoint, like `read_glyph`. The margins
+  and widths of a sheet's cells are all measured at once.
+  """
+  sheet_files = sorted([
+      f for f in folder.glob("*.png")
+      if sheet_file_pattern.fullmatch(f.name) is not None
+    ])
+
+  if not sheet_files:
+    raise Error(
+        f"Could not find any glyph sheets in folder."
+      )
+
+  glyphs = {}
+
+  for sheet_file in sheet_files:
+
+    sheet = Image.open(sheet_file)
+
+    if sheet.mode != "P":
+      raise Error(
+          f"Sheet image '{sheet_file}' must be an indexed image."
+        )
+
+    if (sheet.width % MAX_CELL_SIZE) or (sheet.height % MAX_CELL_SIZE):
+      raise Error(
+          f"Sheet image '{sheet_file}' size must be a multiple of "
+          f"(16, 16), got {sheet.size}."
+        )
+
+    start = int(sheet_file_pattern.fullmatch(sheet_file.name).group(1), 16)
+    columns = sheet.width // MAX_CELL_SIZE
+
+    # Cut the sheet into an array of cells, in codepoint order.
+
+    cells = numpy.asarray(sheet).reshape(
+        sheet.height // MAX_CELL_SIZE,
+        MAX_CELL_SIZE,
+        columns,
+        MAX_CELL_SIZE,
+      ).swapaxes(1, 2).reshape(-1, MAX_CELL_SIZE, MAX_CELL_SIZE)
+
+    filled = (cells != 0)
+    filled_rows = filled.any(axis=2)
+    filled_columns = filled.any(axis=1)
+
+    upper_margins = filled_rows.argmax(axis=1)
+    lower_margins = MAX_CELL_SIZE - filled_rows[:, ::-1].argmax(axis=1)
+    widths = MAX_CELL_SIZE - filled_columns[:, ::-1].argmax(axis=1)
+
+    for cell in numpy.flatnonzero(filled_rows.any(axis=1)):
+
+      x = (cell % columns) * MAX_CELL_SIZE
+      y = (cell // columns) * MAX_CELL_SIZE
+      cell_width = MAX_CELL_SIZE if (widths[cell] > MIN_CELL_SIZE) else MIN_CELL_SIZE
+
+      glyphs[start + int(cell)] = (
+          sheet.crop((x, y, x + cell_width, y + MAX_CELL_SIZE)),
+          int(widths[cell]),
+          int(upper_margins[cell]),
+          int(lower_margins[cell]),
+        )
+
+  return glyphs
+
+
+class PageCursor:
+  """Tracks where the next glyph goes on a font page."""
+
+  def __init__(self):
+    self.x, self.y = 0, 0
+
+  def place(self, width):
+    """
+    Claim space for a glyph that is `width` pixels wide.
+
+    Returns the glyph's tile within the page, or None if the
+    page doesn't have room for it.
+    """
+    x, y = self.x, self.y
+
+    # We might need to move to the next row if the glyph
+    # doesn't fit.
+
+    if (((x * 8) + width) > PAGE_WIDTH):
+      x = 0
+      y += 2
+
+    if ((y + 2) * 8) > PAGE_HEIGHT:
+      return None
+
+    self.x, self.y = x + (width // 8), y
+
+    return ((32 * y) + x)
+
+
+def pack_in_order(cell_widths):
+  """
+  Pack glyphs into pages in the order given.
+
+  Returns a list of pages, each a list of codepoints.
+  """
+  pages = []
+  page = []
+  cursor = PageCursor()
+
+  for codepoint, width in cell_widths.items():
+
+    if cursor.place(width) is None:
+      pages.append(page)
+      page = []
+      cursor = PageCursor()
+      cursor.place(width)
+
+    page.append(codepoint)
+
+  if page:
+    pages.append(page)
+
+  return pages
+
+
+def read_corpus(paths):
+  """
+  Read chapter titles to pack glyphs for.
+
+  Returns a list of titles, each a set of codepoints.
+  """
+  titles = []
+
+  for path in paths:
+
+    if path.is_dir():
+      texts = [f.read_text(encoding="UTF-8") for f in sorted(path.glob("*.txt"))]
+    elif path.is_file():
+      texts = path.read_text(encoding="UTF-8").splitlines()
+    else:
+      raise FileNotFoundError(path)
+
+    titles.extend({ord(c) for c in text} for text in texts if text.strip())
+
+  return titles
+
+
+def pack_by_corpus(cell_widths, titles):
+  """
+  Pack glyphs into pages so that glyphs that are used in
+  the same chapter titles share pages.
+
+  Each page is filled greedily: it starts with the most common
+  glyph that hasn't been packed yet and then repeatedly takes
+  the glyph that appears in the most titles alongside the glyphs
+  already on the page.
+
+  Returns a list of pages, each a list of codepoints.
+  """
+  titles = [{c for c in title if c in cell_widths} for title in titles]
+  titles = [title for title in titles if title]
+
+  frequency = Counter(c for title in titles for c in title)
+
+  titles_with = {}
+  for i, title in enumerate(titles):
+    for c in title:
+      titles_with.setdefault(c, []).append(i)
+
+  unpacked = set(cell_widths)
+  pages = []
+
+  while unpacked:
+
+    page = []
+    cursor = PageCursor()
+    affinity = Counter()
+
+    # Entries are (-affinity, -frequency, codepoint) so that ties
+    # fall back to the most common glyph and then codepoint order.
+    # Entries go stale as affinities grow and are skipped.
+
+    heap = [(0, -frequency[c], c) for c in unpacked]
+    heapq.heapify(heap)
+
+    while heap:
+
+      score, _, c = heapq.heappop(heap)
+
+      if (c not in unpacked) or (-score != affinity[c]):
+        continue
+
+      # Glyphs that don't fit are left for a later page.
+
+      if cursor.place(cell_widths[c]) is None:
+        continue
+
+      page.append(c)
+      unpacked.remove(c)
+
+      for i in titles_with.get(c, []):
+        for other in titles[i]:
+          if other in unpacked:
+            affinity[other] += 1
+            heapq.heappush(heap, (-affinity[other], -frequency[other], other))
+
+    pages.append(page)
+
+  return pages
+
+
+def count_title_pages(pages, titles):
+  """Count the number of titles that use each number of pages."""
+  page_of = {c: i for i, page in enumerate(pages) for c in page}
+
+  return Counter(
+      len({page_of[c] for c in title if c in page_of})
+      for title in titles
+    )
+
+
+def report_packing(before, after, titles):
+  """Print how many pages each title uses with and without grouping."""
+  before = count_title_pages(before, titles)
+  after = count_title_pages(after, titles)
+
+  print("Font pages per chapter title (codepoint order -> corpus order):")
+
+  for count in sorted(set(before) | set(after)):
+    print(f"  {count:2d} pages: {before[count]:5d} -> {after[count]:5d} titles")
+
+  total = max(1, len(titles))
+  mean_before = sum(k * v for k, v in before.items()) / total
+  mean_after = sum(k * v for k, v in after.items()) / total
+
+  print(f"  mean:     {mean_before:5.2f} -> {mean_after:5.2f}")
+
+
+def get_glyph_shades(glyphs):
+  """Get the sorted list of colors used by glyphs, other than 0."""
+  shades = set()
+
+  for glyph_image, *_ in glyphs.values():
+    shades.update(color & 0xF for _, color in glyph_image.getcolors())
+
+  shades.discard(0)
+
+  return sorted(shades)
+
+
+def build_glyph_record(glyph, shades):
+  """
+  Pack a glyph into a list of slices, 8 pixels each, for the
+  rows between its upper and lower margins.
+
+  When `shades` is given, each pixel is stored at 2bpp as the
+  position of its color in `shades`, plus one. Otherwise, pixels
+  are stored at 4bpp.
+  """
+  glyph_image, glyph_width, upper, lower = glyph
+  pixels = glyph_image.load()
+
+  bits = 4 if shades is None else 2
+
+  slices = []
+
+  for row in range(upper, lower):
+    for column in range(0, glyph_width, 8):
+
+      packed = 0
+
+      for i in range(8):
+
+        if (column + i) >= min(glyph_width, glyph_image.width):
+          continue
+
+        pixel = pixels[column + i, row] & 0xF
+
+        if (shades is not None) and (pixel != 0):
+          pixel = shades.index(pixel) + 1
+
+        packed |= pixel << (bits * i)
+
+      slices.append(packed)
+
+  return slices
+
+
+def build_glyph_record_array(numpy, glyph, shades):
+  """
+  Pack a glyph into slices like `build_glyph_record`,
+  but using array operations.
+  """
+  glyph_image, glyph_width, upper, lower = glyph
+
+  bits = 4 if shades is None else 2
+  slice_count = (glyph_width + 7) // 8
+  visible = min(glyph_width, glyph_image.width)
+
+  pixels = numpy.zeros((lower - upper, slice_count * 8), dtype=numpy.uint32)
+  pixels[:, :visible] = numpy.asarray(glyph_image)[upper:lower, :visible] & 0xF
+
+  if shades is not None:
+    colors = numpy.zeros(16, dtype=numpy.uint32)
+    colors[shades] = numpy.arange(1, len(shades) + 1)
+    pixels = colors[pixels]
+
+  shifts = numpy.arange(8, dtype=numpy.uint32) * bits
+  slices = (pixels.reshape(-1, 8) << shifts).sum(axis=1, dtype=numpy.uint32)
+
+  return slices.tolist()
+
+
+def build_shade_expansion(shades):
+  """
+  Build a table that expands a byte of 2bpp pixels into
+  a short of 4bpp pixels.
+  """
+  colors = [0] + shades + ([0] * (3 - len(shades)))
+
+  return [
+      sum(colors[(byte >> (2 * i)) & 3] << (4 * i) for i in range(4))
+      for byte in range(256)
+    ]
+
+
+def build_glyph_store(glyphs, composites, filename, numpy, binary):
+  """
+  Build the glyph record installer file. Composite
+  glyphs don't have records, and their offsets are 0.
+
+  Records are packed using array operations if `numpy` is
+  given, and written as binary files if `binary` is set.
+  """
+  shades = get_glyph_shades(glyphs)
+
+  if len(shades) <= 3:
+    depth, template, code = 2, "SHORT", "H"
+    expansion = format_shorts(build_shade_expansion(shades))
+  else:
+    depth, template, code, shades = 4, "WORD", "I", None
+    expansion = ""
+
+  # Records are word-aligned, so the offset of each
+  # record is the padded size of the ones before it.
+
+  offsets = []
+  data = bytearray()
+  records = []
+
+  for codepoint, glyph in glyphs.items():
+
+    if codepoint in composites:
+      offsets.append(0)
+      continue
+
+    if numpy is not None:
+      slices = build_glyph_record_array(numpy, glyph, shades)
+    else:
+      slices = build_glyph_record(glyph, shades)
+
+    offsets.append(len(data))
+    data += struct.pack(f"<{len(slices)}{code}", *slices)
+    data += bytes(-len(data) % 4)
+
+    if binary:
+      continue
+
+    digits = depth * 2
+
+    records.append(glyph_record_template.format(
+        codepoint=codepoint,
+        slices="\n".join([
+            f"  {template} " + " ".join([f"0x{s:0{digits}X}" for s in batch])
+            for batch in batched(slices, 8)
+          ]),
+      ))
+
+  if binary:
+    record_offsets = write_binary(
+        filename.parent,
+        "GlyphRecordOffsets",
+        struct.pack(f"<{len(offsets)}I", *offsets)
+      )
+    records = write_binary(filename.parent, "GlyphRecords", bytes(data))
+
+  else:
+    record_offsets = "\n".join([
+        offset_template.format(
+            entries=" ".join([f"0x{offset:08X}" for offset in batch])
+          )
+        for batch in batched(offsets, 8)
+      ])
+    records = "\n".join(records)
+
+  installer = glyph_store_text.format(
+      depth=depth,
+      expansion=expansion,
+      record_offsets=record_offsets,
+      records=records,
+    )
+
+  with filename.open("w") as o:
+    o.write(installer)
+
+  return depth
+
+
+def save_page_image(image, filename):
+  """
+  Save a font page or chapter title strip image, unless the
+  file already has exactly the same contents. Returns whether
+  the file was written.
+  """
+  data = BytesIO()
+  image.save(data, format="PNG")
+  data = data.getvalue()
+
+  if filename.exists() and (filename.read_bytes() == data):
+    return False
+
+  filename.write_bytes(data)
+  return True
+
+
+def remove_stale_pages(folder, pagecount):
+  """
+  Delete font page images left over from an earlier font
+  with more pages. Returns the number of pages deleted.
+  """
+  stale = [
+      f for f in folder.glob("CTF_Generated_Page_*.png")
+      if (match := page_file_pattern.fullmatch(f.name))
+      and (int(match.group("page")) >= pagecount)
+    ]
+
+  for f in stale:
+    f.unlink()
+
+  return len(stale)
+
+
+def get_font_size(codepoints, whitespace, kerning, pagecount):
+  """
+  Estimate how much ROM a font needs, in bytes. Font pages are
+  counted uncompressed.
+  """
+  metadata = dict.fromkeys(codepoints)
+
+  blocks, index = build_index(metadata, whitespace)
+  _, _, matrix = build_kerning_classes(metadata, kerning)
+
+  return sum([
+      METADATA_ENTRY_SIZE * (len(metadata) + 1),
+      2 * (1 + len(blocks) + len(index)),
+      len(matrix) * len(matrix[0]),
+      PAGE_SIZE * pagecount,
+    ])
+
+
+def report_subset(dropped, before, after):
+  """Print the glyphs that were dropped and the space saved."""
+  print(f"Dropped {len(dropped)} glyphs not used by the corpus:")
+
+  for batch in batched(sorted(dropped), 8):
+    print("  " + " ".join([f"{c:06X} '{chr(c)}'" for c in batch]))
+
+  print(
+      f"Font size: {before} -> {after} bytes, saving {before - after} "
+      "(font pages counted uncompressed)"
+    )
+
+
+def main():
+  """Process glyphs into sheets and metadata."""
+  Image = require_pillow()
 
   parser = ArgumentParser(
       description=desc,
@@ -386,22 +1517,58 @@ def main():
       type=Path,
       help="A folder that contains glyph images."
     )
+  parser.add_argument(
+      "--corpus",
+      type=Path,
+      action="append",
+      default=[],
+      help=(
+          "A folder of chapter title text files or a text file with\n"
+          "one chapter title per line to group glyphs by. May be\n"
+          "given more than once."
+        )
+    )
+  parser.add_argument(
+      "--glyph-store",
+      action="store_true",
+      help="Store glyphs as uncompressed records instead of font pages."
+    )
+  parser.add_argument(
+      "--subset",
+      action="store_true",
+      help="Only keep glyphs that the corpus uses."
+    )
+  parser.add_argument(
+      "--sheets",
+      type=Path,
+      help="Read glyphs from a folder of glyph sheets instead."
+    )
+  parser.add_argument(
+      "--binary",
+      action="store_true",
+      help="Write tables as binary files instead of installer code."
+    )
 
   args = parser.parse_args()
 
   if not args.folder.is_dir():
     raise NotADirectoryError(args.folder)
 
-  glyph_files = sorted([
-      f for f in args.folder.glob("*.png")
-      if glyph_file_pattern.match(str(f.name)) is not None
-    ])
-
-  if not glyph_files:
+  if args.subset and not args.corpus:
     raise Error(
-        f"Could not find any glyph files in folder."
+        "Subsetting requires at least one corpus."
       )
 
+  numpy = None
+  glyph_files = []
+
+  if args.sheets is not None:
+    if not args.sheets.is_dir():
+      raise NotADirectoryError(args.sheets)
+    numpy = require_numpy()
+  else:
+    glyph_files = find_glyph_files(args.folder)
+
   # This will get combined with the glyph metadata later,
   # along with building up its output file, but we want to
   # catch errors here early because the file is easier to parse.
@@ -417,137 +1584,214 @@ def main():
   if (wf := args.folder.joinpath("Whitespace.txt")).exists():
     whitespace = process_whitespace_file(wf)
 
-  # Maybe naive, but I'm going to use the first glyph's palette for
-  # the first page's palette.
-
-  ref_pal = Image.open(glyph_files[0]).getpalette()
+  glyphs = {}
 
-  current_page = Image.new("P", (256, 64))
-  current_page.putpalette(ref_pal)
+  if args.sheets is not None:
+    glyphs = read_sheets(Image, numpy, args.sheets)
 
-  font_images = []
-  font_page = 0
-  x, y = 0, 0
+  for glyph_file in glyph_files:
 
-  metadata = {}
+    (
+        glyph_codepoint,
+        glyph_image,
+        glyph_width,
+        glyph_upper_margin,
+        glyph_lower_margin,
+      ) = read_glyph(Image, glyph_file)
 
-  for glyph_file in glyph_files:
+    glyphs[glyph_codepoint] = (
+        glyph_image,
+        glyph_width,
+        glyph_upper_margin,
+        glyph_lower_margin,
+      )
 
-    glyph_image = Image.open(glyph_file)
+  # It's unlikely to happen, but ensure that no glyph has
+  # been defined as whitespace already.
 
-    if glyph_image.mode != "P":
+  for glyph_codepoint in glyphs:
+    if glyph_codepoint in whitespace:
       raise Error(
-          f"Glyph image '{glyph_file}' must be an indexed image."
+          f"Codepoint '{glyph_codepoint:06X} already defined as whitespace."
         )
 
-    if (h := glyph_image.height) != 16:
-      raise Error(
-          f"Glyph image '{glyph_file}' must have a height of 16 pixels, "
-          f"got {h}."
-        )
+  # Composite glyphs are found before subsetting, since
+  # their parts need to be kept along with them.
 
-    if (w := glyph_image.width) not in valid_cell_sizes:
+  explicit_composites = {}
+  if (cf := args.folder.joinpath("Composites.txt")).exists():
+    explicit_composites = process_composites_file(cf)
+
+  for codepoint in explicit_composites:
+    if codepoint in whitespace:
       raise Error(
-          f"Glyph image '{glyph_file}' must have a width in pixels of "
-          f"one of {list(valid_cell_sizes)}, got {w}."
+          f"Codepoint '{codepoint:06X} already defined as whitespace."
         )
 
-    match = glyph_file_pattern.match(str(glyph_file.name))
-    glyph_codepoint = int(match.group("codepoint"), base=16)
+  composites = find_composites(Image, glyphs, explicit_composites)
+  glyphs = dict(sorted(glyphs.items()))
 
-    # It's unlikely to happen, but ensure that the glyph hasn't
-    # been defined as whitespace already.
+  titles = read_corpus(args.corpus)
 
-    if glyph_codepoint in whitespace:
+  # When subsetting, drop any glyphs that no title uses.
+
+  if args.subset:
+
+    keep = set()
+    if (kf := args.folder.joinpath("Keep.txt")).exists():
+      keep = process_keep_file(kf)
+
+    used = keep.union(*titles)
+    used |= expand_composites(used, composites)
+    dropped = [c for c in glyphs if c not in used]
+
+    before = get_font_size(
+        glyphs,
+        whitespace,
+        kerning,
+        len(pack_in_order({
+            c: g[0].width for c, g in glyphs.items() if c not in composites
+          }))
+      )
+
+    glyphs = {c: glyph for c, glyph in glyphs.items() if c in used}
+    composites = {c: parts for c, parts in composites.items() if c in used}
+
+    if not glyphs:
       raise Error(
-          f"Codepoint '{glyph_codepoint:06X} already defined as whitespace."
+          "No glyphs are used by the corpus."
         )
 
-    glyph_bbox = glyph_image.getbbox()
-    _, glyph_upper_margin, glyph_width, glyph_lower_margin = glyph_bbox
+  if composites:
+    saved_tiles = sum([(glyphs[c][0].width // 8) * 2 for c in composites])
+    print(f"Found {len(composites)} composite glyphs, saving {saved_tiles} tiles.")
 
-    # We might need to emit the current page if the glyph doesn't fit.
+  # Decide which page each glyph goes on. Stored glyphs
+  # don't have pages, so they all get put on the first one.
+  # Composite glyphs are drawn using their parts, so
+  # they don't need to be on a page at all.
 
-    required_tiles = (w * h) // (8 * 8)
+  cell_widths = {
+      c: glyph[0].width for c, glyph in glyphs.items() if c not in composites
+    }
 
-    if (required_tiles + ((32 * y) + x)) > MAX_PAGE_TILES:
+  pages = pack_in_order(cell_widths)
 
-      if len(font_images) == MAX_PAGES:
-        raise Error(
-            "Cannot create font page; too many font pages."
-          )
+  if args.glyph_store:
+    pages = []
 
-      font_images.append(current_page)
+  elif args.corpus:
+    titles = [expand_composites(title, composites) for title in titles]
+    packed_pages = pack_by_corpus(cell_widths, titles)
+    report_packing(pages, packed_pages, titles)
+    pages = packed_pages
 
-      x, y = 0, 0
-      font_page += 1
+  if len(pages) > MAX_PAGES:
+    raise Error(
+        "Cannot create font page; too many font pages."
+      )
 
-      current_page = Image.new("P", (256, 64))
-      current_page.putpalette(ref_pal)
+  if args.subset:
+    after = get_font_size(glyphs, whitespace, kerning, len(pages))
+    report_subset(dropped, before, after)
 
-    # We might need to move to the next row if the glyph
-    # doesn't fit.
+  # Maybe naive, but I'm going to use the first glyph's palette for
+  # the first page's palette.
 
-    if (((x * 8) + w) > 256):
-      x = 0
-      y += 2
+  ref_pal = next(iter(glyphs.values()))[0].getpalette()
+
+  font_images = []
+  placements = {}
+
+  for font_page, page in enumerate(pages):
+
+    current_page = Image.new("P", (PAGE_WIDTH, PAGE_HEIGHT))
+    current_page.putpalette(ref_pal)
 
-    current_page.paste(glyph_image, (x * 8, y * 8))
+    cursor = PageCursor()
 
-    # Next, override the glyph's metadata if the filename specified data.
+    for glyph_codepoint in page:
 
-    if (mw := match.group("width")) is not None:
-      glyph_width = mw
+      glyph_image = glyphs[glyph_codepoint][0]
 
-    if (mu := match.group("upper_margin")) is not None:
-      glyph_upper_margin = mu
+      tile = cursor.place(glyph_image.width)
+      current_page.paste(glyph_image, ((tile % 32) * 8, (tile // 32) * 8))
 
-    if (ml := match.group("lower_margin")) is not None:
-      glyph_lower_margin = ml
+      placements[glyph_codepoint] = (font_page, tile)
 
-    # Finally, save the metadata.
+    font_images.append(current_page)
+
+  # Finally, save the metadata. This is kept in codepoint order
+  # no matter how the glyphs were packed.
+
+  metadata = {}
+
+  for glyph_codepoint, glyph in glyphs.items():
+
+    (
+        glyph_image,
+        glyph_width,
+        glyph_upper_margin,
+        glyph_lower_margin,
+      ) = glyph
+
+    font_page, tile = placements.get(glyph_codepoint, (0, 0))
 
     metadata[glyph_codepoint] = (
         glyph_width,
-        True if (w == MAX_CELL_SIZE) else False,
+        True if (glyph_image.width == MAX_CELL_SIZE) else False,
         glyph_upper_margin,
         glyph_lower_margin,
         font_page,
-        ((32 * y) + x),
+        tile,
       )
 
-    x += (w // 8)
+  # Finally, build the output files.
 
-  # Don't forget to emit the last font page
+  kerning_classes = build_kerning_classes(metadata, kerning)
+  composite_starts, composite_parts = build_composite_parts(metadata, composites)
 
-  if current_page.getbbox() is not None:
+  metadata_file = args.folder.joinpath("CTF_Generated_Metadata.tsv")
+  build_metadata_file(metadata, kerning_classes, composite_starts, metadata_file)
 
-    if len(font_images) == MAX_PAGES:
-      raise Error(
-          "Cannot create font page; too many font pages."
-        )
+  written = [
+      save_page_image(im, args.folder.joinpath(f"CTF_Generated_Page_{i:02d}.png"))
+      for i, im in enumerate(font_images)
+    ]
 
-    font_images.append(current_page)
+  if font_images:
+    print(f"{sum(written)} of {len(font_images)} font pages changed.")
 
-  # Finally, build the output files.
+  # Pages past the end would otherwise still be picked up by
+  # the Makefile, which couldn't tell that there are fewer now.
 
-  metadata_file = args.folder.joinpath("CTF_Generated_Metadata.tsv")
-  build_metadata_file(metadata, kerning, metadata_file)
+  removed = remove_stale_pages(args.folder, len(font_images))
+  if removed:
+    print(f"Deleted {removed} stale font pages.")
 
-  if whitespace:
-    whitespace_file = args.folder.joinpath("CTF_Generated_Whitespace.tsv")
-    build_whitespace_file(whitespace, whitespace_file)
+  glyph_store_file = args.folder.joinpath("CTF_Generated_Glyphs.event")
 
-  if kerning:
-    kerning_file = args.folder.joinpath("CTF_Generated_Kerning.event")
-    build_kerning_file(kerning, kerning_file)
+  if args.glyph_store:
+    depth = build_glyph_store(
+        glyphs, composites, glyph_store_file, numpy, args.binary
+      )
+    print(f"Stored {len(glyphs) - len(composites)} glyphs at {depth}bpp.")
 
-  for i, im in enumerate(font_images):
-    im.save(args.folder.joinpath(f"CTF_Generated_Page_{i:02d}.png"))
+  else:
+    with glyph_store_file.open("w") as o:
+      o.write(no_glyph_store_text)
 
   pagecount = len(font_images)
   installer_file = args.folder.joinpath("CTF_Generated_Installer.event")
-  build_installer(metadata, whitespace, kerning, pagecount, installer_file)
+  build_installer(
+      metadata,
+      whitespace,
+      kerning_classes,
+      (composite_starts, composite_parts),
+      pagecount,
+      installer_file,
+      args.binary,
+    )
 
   return 0
 
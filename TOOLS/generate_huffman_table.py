@@ -0,0 +1,348 @@
+#!/usr/bin/python3
+
+"""
+Build a lookup table for decoding the game's Huffman-compressed text.
+
+This script reads the Huffman tree out of the base ROM and writes an
+installer containing a table that decodes up to 8 bits of compressed text
+at a time, for use by the Skip Huffman Decompression hack's table decoder.
+
+"""
+
+import sys
+import struct
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+desc = """Build a Huffman text decoding table from a ROM.
+
+The game's text is compressed using a Huffman tree, which the vanilla decoder
+walks one bit at a time. This script reads the tree out of the ROM and builds
+a table with an entry for every possible 8 bits of compressed text, so that
+the table decoder can resolve up to 8 bits, and often several characters,
+with a single lookup.
+
+The tree is an array of 4-byte nodes, each of which is a pair of halfwords.
+An internal node's halfwords are the indices of its children for a 0 bit and
+a 1 bit. A leaf node has its second halfword's uppermost bit set, and its first
+halfword is the text that it decodes to: the low byte, and then the high byte
+if it isn't 00. Decoding stops after a leaf whose low byte is 00. Compressed
+text is read starting with the lowest bit of each byte, and every character
+starts back at the root node.
+
+'--tree' is the ROM offset of the pointer to the tree's nodes and '--root' is
+the ROM offset of the pointer to the pointer to the root node, which are
+where the vanilla decoder gets them from. The defaults are for FE8U.
+
+Each table entry is a word. If one or more characters finish within the 8
+bits, its lowest 4 bits are the number of bits used up to the end of the last
+character that fits, bits 4-5 are the number of bytes of text (1 to 3), bit 7
+is set if the text ends with the terminator, and the upper 3 bytes are the
+text itself, lowest byte first. Otherwise, its lowest 4 bits are 0 and its
+upper halfword is the index of the node that the 8 bits end at, which the
+decoder continues from one bit at a time.
+
+The output is an installer that contains the table and a pointer to the tree.
+
+"""
+
+ROM_BASE = 0x08000000
+ROM_SIZE = 0x02000000
+
+DEFAULT_TREE_POINTER = 0x000006E0
+DEFAULT_ROOT_POINTER = 0x000006DC
+DEFAULT_TEXT_TABLE_POINTER = 0x0000A2A0
+
+UNCOMPRESSED_FLAG = 0x80000000
+LENGTH_PREFIXED_FLAG = 0x40000000
+TEXT_FLAGS = UNCOMPRESSED_FLAG | LENGTH_PREFIXED_FLAG
+
+LOOKUP_BITS = 8
+LOOKUP_SIZE = 1 << LOOKUP_BITS
+
+MAX_ENTRY_TEXT = 3
+
+ENTRY_LENGTH_SHIFT = 4
+ENTRY_END = 0x80
+ENTRY_TEXT_SHIFT = 8
+ENTRY_NODE_SHIFT = 16
+
+LEAF_FLAG = 0x8000
+
+installer_text = """
+// This file is generated by `generate_huffman_table.py`.
+
+ALIGN 4; gHuffmanTree:; WORD 0x{tree:08X}
+
+ALIGN 4; gHuffmanLookupTable:
+{entries}
+"""
+
+entry_template = "  WORD {entries}"
+
+
+class Error(Exception):
+  """Generic exception class."""
+
+
+class HuffmanTree:
+  """The game's Huffman tree, read from a ROM."""
+
+  def __init__(self, rom, tree_pointer, root_pointer):
+    self.rom = rom
+    self.base = read_pointer(rom, tree_pointer)
+    self.root = read_pointer(rom, read_pointer(rom, root_pointer) - ROM_BASE)
+
+    if (self.root - self.base) % 4 != 0:
+      raise Error(
+          f"Root node 0x{self.root:08X} isn't a node of the tree "
+          f"at 0x{self.base:08X}."
+        )
+
+    self.root_index = (self.root - self.base) // 4
+
+  def node(self, index):
+    """Get a node's pair of halfwords."""
+    offset = (self.base - ROM_BASE) + (index * 4)
+    if (index < 0) or ((offset + 4) > len(self.rom)):
+      raise Error(f"Huffman tree node {index} is outside of the ROM.")
+    return struct.unpack_from("<HH", self.rom, offset)
+
+  def is_leaf(self, index):
+    """Check whether a node is a leaf."""
+    return (self.node(index)[1] & LEAF_FLAG) != 0
+
+  def child(self, index, bit):
+    """Get a node's child for a bit."""
+    return self.node(index)[bit]
+
+  def leaf_text(self, index):
+    """
+    Get the text that a leaf decodes to, and whether
+    decoding stops after it.
+    """
+    value = self.node(index)[0]
+    low, high = value & 0xFF, value >> 8
+
+    if low == 0:
+      return bytes([low]), True
+
+    return (bytes([low, high]) if high != 0 else bytes([low])), False
+
+
+def read_pointer(rom, offset):
+  """Read a ROM pointer at a ROM offset."""
+  if (offset < 0) or ((offset + 4) > len(rom)):
+    raise Error(f"Pointer at 0x{offset:08X} is outside of the ROM.")
+
+  pointer, = struct.unpack_from("<I", rom, offset)
+  if not (ROM_BASE <= pointer < (ROM_BASE + len(rom))):
+    raise Error(
+        f"Value at 0x{offset:08X} (0x{pointer:08X}) isn't a ROM pointer."
+      )
+
+  return pointer
+
+
+def read_text_table_offset(rom, text_table_pointer):
+  """Get the ROM offset of the text table from its pointer."""
+  return read_pointer(rom, text_table_pointer) - ROM_BASE
+
+
+def read_text_table(rom, text_table_pointer, count):
+  """
+  Read the text table, returning the text ID and
+  pointer of each entry.
+  """
+  offset = read_text_table_offset(rom, text_table_pointer)
+  entries = []
+
+  text_id = 0
+  while (count is None) or (text_id < count):
+
+    if (offset + 4) > len(rom):
+      break
+
+    pointer, = struct.unpack_from("<I", rom, offset)
+    address = pointer & ~TEXT_FLAGS
+
+    if not (ROM_BASE <= address < (ROM_BASE + len(rom))):
+      if count is None:
+        break
+      raise Error(
+          f"Text ID 0x{text_id:04X} (0x{pointer:08X}) isn't a ROM pointer."
+        )
+
+    entries.append((text_id, pointer))
+
+    offset += 4
+    text_id += 1
+
+  return entries
+
+
+def build_lookup_entry(tree, bits):
+  """
+  Build the table entry for 8 bits of compressed text,
+  starting at the root node.
+  """
+  text = b""
+  used = 0
+  end = False
+
+  node = tree.root_index
+  for i in range(LOOKUP_BITS):
+
+    node = tree.child(node, (bits >> i) & 1)
+
+    if not tree.is_leaf(node):
+      continue
+
+    leaf_text, end = tree.leaf_text(node)
+    if (len(text) + len(leaf_text)) > MAX_ENTRY_TEXT:
+      end = False
+      break
+
+    text += leaf_text
+    used = i + 1
+    node = tree.root_index
+
+    if end:
+      break
+
+  if used == 0:
+    return node << ENTRY_NODE_SHIFT
+
+  return (
+      used
+      | (len(text) << ENTRY_LENGTH_SHIFT)
+      | (ENTRY_END if end else 0)
+      | (int.from_bytes(text, "little") << ENTRY_TEXT_SHIFT)
+    )
+
+
+def build_lookup_table(tree):
+  """Build the table entries for every 8 bits of compressed text."""
+  return [build_lookup_entry(tree, bits) for bits in range(LOOKUP_SIZE)]
+
+
+def decode_reference(tree, rom, address, limit=0x1000):
+  """
+  Decode a compressed text entry one bit at a time,
+  like the vanilla decoder. Returns the text and the
+  number of bytes of compressed text that were read.
+  """
+  text = b""
+  offset = address - ROM_BASE
+  node = tree.root_index
+
+  while len(text) < limit:
+
+    if offset >= len(rom):
+      raise Error(f"Text at 0x{address:08X} runs off the end of the ROM.")
+
+    byte = rom[offset]
+    offset += 1
+
+    for i in range(8):
+
+      node = tree.child(node, (byte >> i) & 1)
+
+      if not tree.is_leaf(node):
+        continue
+
+      leaf_text, end = tree.leaf_text(node)
+      text += leaf_text
+      node = tree.root_index
+
+      if end:
+        return text, offset - (address - ROM_BASE)
+
+  raise Error(f"Text at 0x{address:08X} doesn't end.")
+
+
+def read_rom(filename):
+  """Read a ROM, ensuring that it's a reasonable size."""
+  rom = filename.read_bytes()
+  if not (0 < len(rom) <= ROM_SIZE):
+    raise Error(f"{filename} isn't a GBA ROM.")
+  return rom
+
+
+def add_tree_arguments(parser):
+  """Add the arguments for finding the Huffman tree."""
+  parser.add_argument(
+      "--tree",
+      type=lambda s: int(s, 0),
+      default=DEFAULT_TREE_POINTER,
+      help="The ROM offset of the pointer to the tree's nodes."
+    )
+  parser.add_argument(
+      "--root",
+      type=lambda s: int(s, 0),
+      default=DEFAULT_ROOT_POINTER,
+      help="The ROM offset of the pointer to the root node's pointer."
+    )
+
+
+def add_text_table_arguments(parser):
+  """Add the arguments for finding the text table."""
+  parser.add_argument(
+      "--text-table",
+      type=lambda s: int(s, 0),
+      default=DEFAULT_TEXT_TABLE_POINTER,
+      help="The ROM offset of the pointer to the text table."
+    )
+  parser.add_argument(
+      "--count",
+      type=lambda s: int(s, 0),
+      help="The number of entries in the text table."
+    )
+
+
+def build_installer(tree, table, filename):
+  """Build the table's installer file."""
+  installer = installer_text.format(
+      tree=tree.base,
+      entries="\n".join([
+          entry_template.format(
+              entries=" ".join([f"0x{entry:08X}" for entry in table[i:i + 8]])
+            )
+          for i in range(0, len(table), 8)
+        ]),
+    )
+
+  with filename.open("w") as o:
+    o.write(installer)
+
+
+def main():
+  """Build the Huffman lookup table installer."""
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "rom",
+      type=Path,
+      help="The base ROM."
+    )
+  parser.add_argument(
+      "output",
+      type=Path,
+      help="The installer file to write."
+    )
+  add_tree_arguments(parser)
+
+  args = parser.parse_args()
+
+  tree = HuffmanTree(read_rom(args.rom), args.tree, args.root)
+  table = build_lookup_table(tree)
+
+  build_installer(tree, table, args.output)
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
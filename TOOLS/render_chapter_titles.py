@@ -0,0 +1,439 @@
+#!/usr/bin/python3
+
+"""
+Pre-render static chapter titles using the chapter title font.
+
+This script takes the chapter title font's glyph folder, the special chapter
+title table, and the folder of chapter title text files and renders each
+title into an image that can be decompressed straight into VRAM, along with
+a compiled glyph stream that only has to be drawn.
+
+"""
+
+import sys
+import csv
+import re
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+from generate_chapter_title_font import (
+    Error,
+    batched,
+    require_pillow,
+    require_numpy,
+    find_glyph_files,
+    read_glyph,
+    read_sheets,
+    process_kerning_file,
+    process_whitespace_file,
+    process_composites_file,
+    find_composites,
+    save_page_image,
+  )
+
+desc = """Pre-render static chapter titles using the chapter title font.
+
+Chapter titles in the special chapter title table are fixed when building,
+so there's no reason to draw them glyph-by-glyph in-game. This script renders
+each of them into a 256x16 pixel image (32x2 tiles) using the same layout
+rules as the in-game renderer: whitespace widths, kerning, a one pixel
+overlap between glyphs, composite glyphs, and centering within the chapter
+title's width.
+
+Special chapter titles are matched to text files by name: a table entry that
+points to 'g<Name>ChapterTitle' is rendered from '<Name>.txt' in the text
+folder. Entries that don't have a matching text file are left to be drawn
+in-game.
+
+The outputs are an image for each rendered title, named
+'CTF_Generated_Strip_<Name>.png', and an Event Assembler installer named
+'CTF_Generated_Strips.event' that contains a table of pointers to the
+compressed images, parallel to the special chapter title table. Like the font
+generator, this expects the images to be converted into compressed binaries
+by some other tool.
+
+Titles are also compiled into glyph streams, which are much smaller than
+the images but still skip decoding the title's text and looking up its
+glyphs in-game. A glyph stream begins with a header of two shorts: the number
+of glyphs and the number of pixels that the title is indented by. Each glyph
+follows as three bytes: its index in the font metadata table as a little
+endian short and the distance in pixels from the previous glyph's position,
+or from the start of the title for the first glyph, with kerning and
+whitespace already applied. The streams are written to an Event Assembler
+installer named 'CTF_Generated_Streams.event' with a table of pointers to
+them, parallel to the special chapter title table. This requires the font's
+metadata file, 'CTF_Generated_Metadata.tsv', which is created by the font
+generator.
+
+If the font was generated with '--sheets', the same '--sheets' folder must
+be given here, since the glyphs aren't sliced into the font's folder.
+
+The installer files are Event Assembler syntax files that are '#include'ed
+by the Chapter Titles as Text EA installer, and shouldn't be '#include'ed by
+user code.
+
+"""
+
+CHAPTER_TITLE_WIDTH = 192
+STRIP_WIDTH = 256
+STRIP_HEIGHT = 16
+
+# See `CTF.h`.
+MAX_GLYPHS = 64
+
+# These terminate chapter title text, see `CTF.h`.
+MSG_END = 0x00
+MSG_PAD = 0x1F
+
+label_pattern = re.compile(r"g(?P<name>\w+)ChapterTitle")
+
+strips_installer_text = """
+ALIGN 4; gSpecialChapterTitleStrips:
+{strip_pointers}
+
+#ifdef __DEBUG
+  MESSAGE Chapter Title Strip Pointers gSpecialChapterTitleStrips to CURRENTOFFSET
+#endif // __DEBUG
+
+ALIGN 4; CTFStripsStart:
+
+{strip_inclusions}
+
+#ifdef __DEBUG
+  MESSAGE Chapter Title Strip Graphics CTFStripsStart to CURRENTOFFSET
+#endif // __DEBUG
+
+"""
+
+strip_pointer_template = "  POIN CTF_Strip_{name}"
+missing_strip_pointer_template = "  WORD 0 // {name}"
+strip_inclusion_template = """
+ALIGN 4; CTF_Strip_{name}:
+#incbin "CTF_Generated_Strip_{name}.4bpp.lz77"
+"""
+
+streams_installer_text = """
+ALIGN 4; gSpecialChapterTitleStreams:
+{stream_pointers}
+
+#ifdef __DEBUG
+  MESSAGE Chapter Title Stream Pointers gSpecialChapterTitleStreams to CURRENTOFFSET
+#endif // __DEBUG
+
+ALIGN 4; CTFStreamsStart:
+
+{streams}
+
+#ifdef __DEBUG
+  MESSAGE Chapter Title Glyph Streams CTFStreamsStart to CURRENTOFFSET
+#endif // __DEBUG
+
+"""
+
+stream_pointer_template = "  POIN CTF_Stream_{name}"
+stream_template = """
+ALIGN 4; CTF_Stream_{name}:
+  SHORT {count} 0x{padding:04X}
+{glyphs}"""
+stream_glyphs_template = "  BYTE {entries}"
+
+
+def read_font(folder, sheets=None):
+  """
+  Read glyph images and metadata from the font's folder. Glyphs
+  are read from the `sheets` folder instead, if it's given.
+  """
+  Image = require_pillow()
+
+  glyphs = {}
+  if sheets is not None:
+    glyphs = read_sheets(Image, require_numpy(), sheets)
+  else:
+    for glyph_file in find_glyph_files(folder):
+      codepoint, image, width, upper, lower = read_glyph(Image, glyph_file)
+      glyphs[codepoint] = (image, width, upper, lower)
+
+  kerning = {}
+  if (kf := folder.joinpath("Kerning.txt")).exists():
+    kerning = process_kerning_file(kf)
+
+  whitespace = {}
+  if (wf := folder.joinpath("Whitespace.txt")).exists():
+    whitespace = process_whitespace_file(wf)
+
+  explicit_composites = {}
+  if (cf := folder.joinpath("Composites.txt")).exists():
+    explicit_composites = process_composites_file(cf)
+
+  composites = find_composites(Image, glyphs, explicit_composites)
+
+  return glyphs, kerning, whitespace, composites
+
+
+def read_glyph_indices(folder):
+  """Get each glyph's index in the font metadata table."""
+  metadata_file = folder.joinpath("CTF_Generated_Metadata.tsv")
+
+  with metadata_file.open("r", encoding="UTF-8") as m:
+    rows = [row for row in csv.reader(m, dialect=csv.excel_tab) if row]
+
+  return {int(row[1], 16): i for i, row in enumerate(rows[1:])}
+
+
+def get_kerning_adjustment(kerning, left, right):
+  """Get the kerning between two glyphs, like `GetKerningAdjustment`."""
+  return kerning.get(left, {}).get(right, 0)
+
+
+def get_parts(codepoint, composites):
+  """Get the (codepoint, x, y) parts that a glyph is drawn with."""
+  return composites.get(codepoint, [(codepoint, 0, 0)])
+
+
+def layout_title(text, glyphs, kerning, whitespace, composites):
+  """
+  Lay out a chapter title like `LoadChapterTitleGfx`.
+
+  Returns a list of (codepoint, x) pairs for each glyph, relative
+  to the start of the title, and the padding used to center the title.
+  Like the in-game layout, glyphs past `MAX_GLYPHS` are dropped, with
+  each part of a composite glyph counting as a glyph.
+  """
+  placements = []
+  part_count = 0
+  position = 0
+  previous = None
+
+  for character in text:
+
+    codepoint = ord(character)
+
+    if codepoint in (MSG_END, MSG_PAD):
+      break
+
+    if codepoint in whitespace:
+      position += whitespace[codepoint]
+      previous = None
+
+    elif codepoint in glyphs:
+
+      if previous is not None:
+        position += get_kerning_adjustment(kerning, previous, codepoint)
+
+      if part_count < MAX_GLYPHS:
+        placements.append((codepoint, position))
+        part_count += len(get_parts(codepoint, composites))
+
+      _, width, _, _ = glyphs[codepoint]
+      position += width - 1
+      previous = codepoint
+
+    else:
+      # Characters that aren't in the font are treated like
+      # zero-width whitespace.
+      previous = None
+
+  # C division truncates toward zero.
+  padding = int((CHAPTER_TITLE_WIDTH - position) / 2)
+
+  return placements, padding
+
+
+def render_title(Image, text, glyphs, kerning, whitespace, composites, palette):
+  """Render a chapter title into a strip image."""
+  strip = Image.new("P", (STRIP_WIDTH, STRIP_HEIGHT))
+  strip.putpalette(palette)
+  pixels = strip.load()
+
+  placements, padding = layout_title(
+      text, glyphs, kerning, whitespace, composites
+    )
+
+  # Composite glyphs are drawn part-by-part, and parts
+  # past `MAX_GLYPHS` are dropped.
+
+  parts = [
+      (part, x + part_x, part_y)
+      for codepoint, x in placements
+      for part, part_x, part_y in get_parts(codepoint, composites)
+    ][:MAX_GLYPHS]
+
+  for codepoint, x, y in parts:
+
+    image, width, upper, lower = glyphs[codepoint]
+    glyph_pixels = image.load()
+
+    for row in range(max(upper, -y), min(lower, STRIP_HEIGHT - y)):
+      for column in range(min(width, image.width)):
+
+        dest_x = padding + x + column
+        if not (0 <= dest_x < STRIP_WIDTH):
+          continue
+
+        # Overlapping glyph pixels are combined
+        # just like the in-game renderer does it.
+        pixels[dest_x, row + y] |= (glyph_pixels[column, row] & 0xF)
+
+  return strip
+
+
+def compile_title(name, text, glyphs, kerning, whitespace, composites, indices):
+  """
+  Compile a chapter title into a glyph stream. Composite
+  glyphs are split into their parts in-game.
+  """
+  placements, padding = layout_title(
+      text, glyphs, kerning, whitespace, composites
+    )
+
+  entries = []
+  previous = 0
+
+  for codepoint, x in placements:
+
+    advance = x - previous
+    if not (0 <= advance <= 0xFF):
+      raise Error(
+          f"Unable to compile '{name}': glyph U+{codepoint:04X} is "
+          f"{advance} pixels from the previous glyph."
+        )
+
+    index = indices[codepoint]
+    entries.extend([index & 0xFF, index >> 8, advance])
+    previous = x
+
+  return stream_template.format(
+      name=name,
+      count=len(placements),
+      padding=padding & 0xFFFF,
+      glyphs="\n".join([
+          stream_glyphs_template.format(
+              entries=" ".join([f"0x{b:02X}" for b in batch])
+            )
+          for batch in batched(entries, 15)
+        ]),
+    )
+
+
+def read_special_titles(table):
+  """Get the names of the special chapter titles, in table order."""
+  with table.open("r", encoding="UTF-8") as t:
+    rows = [row for row in csv.reader(t, dialect=csv.excel_tab) if row]
+
+  names = []
+  for _, label in rows[1:]:
+    match = label_pattern.fullmatch(label.strip())
+    names.append(match.group("name") if match is not None else label)
+
+  return names
+
+
+def main():
+  """Render special chapter titles into strips."""
+  Image = require_pillow()
+
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "folder",
+      type=Path,
+      help="The chapter title font's glyph folder."
+    )
+  parser.add_argument(
+      "special_titles",
+      type=Path,
+      help="The special chapter title table."
+    )
+  parser.add_argument(
+      "text_folder",
+      type=Path,
+      help="A folder that contains UTF-8 encoded chapter title text files."
+    )
+  parser.add_argument(
+      "--sheets",
+      type=Path,
+      help="Read glyphs from a folder of glyph sheets instead."
+    )
+
+  args = parser.parse_args()
+
+  for folder in (args.folder, args.text_folder):
+    if not folder.is_dir():
+      raise NotADirectoryError(folder)
+
+  glyphs, kerning, whitespace, composites = read_font(args.folder, args.sheets)
+  indices = read_glyph_indices(args.folder)
+
+  palette = next(iter(glyphs.values()))[0].getpalette()
+
+  strip_pointers = []
+  strip_inclusions = []
+  stream_pointers = []
+  streams = []
+  rendered = set()
+  written = []
+
+  for name in read_special_titles(args.special_titles):
+
+    if name in rendered:
+      strip_pointers.append(strip_pointer_template.format(name=name))
+      stream_pointers.append(stream_pointer_template.format(name=name))
+      continue
+
+    if not (text_file := args.text_folder.joinpath(f"{name}.txt")).exists():
+      strip_pointers.append(missing_strip_pointer_template.format(name=name))
+      stream_pointers.append(missing_strip_pointer_template.format(name=name))
+      continue
+
+    text = text_file.read_text(encoding="UTF-8")
+    strip = render_title(
+        Image, text, glyphs, kerning, whitespace, composites, palette
+      )
+
+    # Unchanged strips are left alone so that they
+    # don't have to be compressed again.
+
+    written.append(
+        save_page_image(
+            strip, args.folder.joinpath(f"CTF_Generated_Strip_{name}.png")
+          )
+      )
+
+    strip_pointers.append(strip_pointer_template.format(name=name))
+    strip_inclusions.append(strip_inclusion_template.format(name=name))
+
+    stream_pointers.append(stream_pointer_template.format(name=name))
+    streams.append(
+        compile_title(
+            name, text, glyphs, kerning, whitespace, composites, indices
+          )
+      )
+
+    rendered.add(name)
+
+  if written:
+    print(f"{sum(written)} of {len(written)} chapter title strips changed.")
+
+  installer = strips_installer_text.format(
+      strip_pointers="\n".join(strip_pointers),
+      strip_inclusions="\n".join(strip_inclusions),
+    )
+
+  with args.folder.joinpath("CTF_Generated_Strips.event").open("w") as o:
+    o.write(installer)
+
+  installer = streams_installer_text.format(
+      stream_pointers="\n".join(stream_pointers),
+      streams="\n".join(streams),
+    )
+
+  with args.folder.joinpath("CTF_Generated_Streams.event").open("w") as o:
+    o.write(installer)
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,351 @@
+#!/usr/bin/python3
+
+"""
+Pick which of a ROM's text entries to store uncompressed.
+
+This script estimates how long each compressed text entry takes to decode and
+how much ROM it would take to store uncompressed, and picks the entries that
+save the most decoding time for the ROM that they cost, up to a budget.
+
+"""
+
+import sys
+import csv
+from pathlib import Path
+from argparse import ArgumentParser, RawTextHelpFormatter
+
+from generate_huffman_table import (
+    Error,
+    HuffmanTree,
+    UNCOMPRESSED_FLAG,
+    read_rom,
+    read_text_table,
+    read_text_table_offset,
+    add_tree_arguments,
+    add_text_table_arguments,
+    decode_reference,
+  )
+from convert_raw_text import format_entry
+
+desc = """Pick which text entries to store uncompressed, under a ROM budget.
+
+With Skip Huffman Decompression, each text table entry can either be
+Huffman-compressed or uncompressed. Uncompressed entries are much faster to
+read but take more space. This script decodes every compressed entry in a
+ROM's text table and estimates, using a simple cost model, how many cycles
+each one takes to read each time that it's drawn, compressed or uncompressed.
+It then picks the entries that save the most cycles per byte of ROM, until
+'--budget' bytes have been used, and writes an installer that inserts
+uncompressed copies of them and points the text table at the copies with the
+uppermost bit set. Include the installer after Skip Huffman Decompression
+and after your text, which has to leave the text table where it is in the
+ROM that was read. The compressed entries are left where they are, so the
+budget only counts the new copies.
+
+How often each entry is drawn matters a lot: a short item name that's redrawn
+every time a menu scrolls is worth far more than a line of dialogue that's
+shown once. '--profile' is a tab-separated file with a header row, followed by
+rows of a text ID and the number of times that it was drawn, like the one that
+counting calls to 'GetStringFromIndex' in an emulator would produce. Text IDs
+may be in hexadecimal with a '0x' prefix. Entries that aren't in the profile
+are counted as drawn once, or every entry is without a profile. Without a
+profile, the picks only reflect how well each entry compresses and the fixed
+cost of decoding it, not how often it's drawn, and the summary says so.
+
+The cost model is in cycles, and the defaults are rough estimates for FE8U:
+
+  --huffman-cycles    per bit of compressed text, for the vanilla decoder
+  --decode-cycles     per draw of compressed text, for setting up the decoder
+  --raw-cycles        per byte, for copying uncompressed text a byte at a time
+  --prefixed-cycles   per byte, for copying length-prefixed text in blocks
+  --padding-cycles    per byte, for the pass that removes Huffman padding
+
+Compressed text can end with Huffman padding, which the game removes after
+decoding it. That doesn't always happen for uncompressed entries:
+'GetStringPointerFromIndex' returns them straight from ROM, and
+length-prefixed entries skip it when Skip Huffman Decompression's
+'UnpaddedTextRAM' is set. The padding is removed from the picked entries here
+instead. With '--length-prefixed', the picked entries are written as
+length-prefixed entries.
+
+A summary of the ROM used and the estimated cycles saved is printed, and
+'--report' saves the estimate for every compressed entry as a tab-separated
+file.
+
+"""
+
+TEXT_END = 0x00
+TEXT_LOAD_PORTRAIT = 0x10
+TEXT_HUFFMAN_PADDING = 0x1F
+TEXT_CONTROL_CODE = 0x80
+
+DEFAULT_HUFFMAN_CYCLES = 16
+DEFAULT_DECODE_CYCLES = 250
+DEFAULT_RAW_CYCLES = 20
+DEFAULT_PREFIXED_CYCLES = 3
+DEFAULT_PADDING_CYCLES = 12
+
+installer_header = """
+// This file is generated by `select_text_encoding.py`.
+"""
+
+report_header = [
+    "TextID", "Length", "CompressedBytes", "Draws",
+    "Encoding", "Bytes", "CyclesSaved",
+  ]
+
+
+class Candidate:
+  """A compressed entry that could be stored uncompressed."""
+
+  def __init__(self, text_id, text, compressed_bytes, draws):
+    self.text_id = text_id
+    self.text = text
+    self.compressed_bytes = compressed_bytes
+    self.draws = draws
+    self.bytes = 0
+    self.cycles_saved = 0
+    self.picked = False
+
+
+def remove_huffman_padding(text):
+  """
+  Remove Huffman padding from the end of decoded text
+  the same way that `RemoveHuffmanPadding` does.
+  """
+  text = bytearray(text)
+
+  pos = 0
+  while text[pos] != TEXT_END:
+    if text[pos] == TEXT_LOAD_PORTRAIT:
+      pos += 2
+    elif text[pos] == TEXT_CONTROL_CODE:
+      pos += 1
+    pos += 1
+
+    # A text code at the very end would skip
+    # over the terminator, so leave it alone.
+
+    if pos >= len(text):
+      return bytes(text)
+
+  end = pos
+  pos -= 1
+  while (pos >= 0) and (text[pos] == TEXT_HUFFMAN_PADDING):
+    if (pos == 0) or (text[pos - 1] != TEXT_CONTROL_CODE):
+      end = pos
+    pos -= 1
+
+  return bytes(text[:end]) + bytes([TEXT_END])
+
+
+def read_profile(filename):
+  """Read a profile of how many times each text ID was drawn."""
+  with filename.open("r", newline="") as i:
+    rows = list(csv.reader(i, dialect=csv.excel_tab))[1:]
+
+  try:
+    return {int(row[0], 0): int(row[1], 0) for row in rows if row}
+  except (ValueError, IndexError):
+    raise Error(f"{filename} isn't a profile of text IDs and draw counts.")
+
+
+def estimate_costs(candidates, args):
+  """Estimate each candidate's ROM cost and cycles saved."""
+  for candidate in candidates:
+
+    length = len(candidate.text)
+
+    compressed = (
+        args.decode_cycles
+        + (candidate.compressed_bytes * 8 * args.huffman_cycles)
+        + (length * args.padding_cycles)
+      )
+
+    if args.length_prefixed:
+      uncompressed = length * args.prefixed_cycles
+      candidate.bytes = 4 + ((length + 3) & ~3)
+    else:
+      uncompressed = length * (args.raw_cycles + args.padding_cycles)
+      candidate.bytes = (length + 3) & ~3
+
+    candidate.cycles_saved = candidate.draws * (compressed - uncompressed)
+
+
+def pick_candidates(candidates, budget):
+  """
+  Pick the candidates that save the most cycles per byte
+  of ROM until the budget runs out. Returns the bytes used.
+  """
+  used = 0
+
+  ranked = sorted(
+      [candidate for candidate in candidates if candidate.cycles_saved > 0],
+      key=lambda candidate: candidate.cycles_saved / candidate.bytes,
+      reverse=True,
+    )
+
+  for candidate in ranked:
+    if (used + candidate.bytes) <= budget:
+      candidate.picked = True
+      used += candidate.bytes
+
+  return used
+
+
+def report(candidates, used, budget, profiled):
+  """Print a summary of the picked entries."""
+  picked = [candidate for candidate in candidates if candidate.picked]
+  saved = sum([candidate.cycles_saved for candidate in picked])
+  possible = sum([
+      candidate.cycles_saved
+      for candidate in candidates
+      if candidate.cycles_saved > 0
+    ])
+
+  print(f"Picked {len(picked)} of {len(candidates)} compressed text entries.")
+  print(f"  ROM: {used} of {budget} bytes")
+  print(
+      f"  Estimated cycles saved: {saved} of {possible} "
+      f"({(100 * saved / possible) if possible else 0:.1f}%)"
+    )
+
+  if not profiled:
+    print(
+        "  Without '--profile', every entry was counted as drawn once, "
+        "so these picks don't reflect which entries are drawn often."
+      )
+
+
+def write_report(candidates, args, filename):
+  """Save the estimate for each entry."""
+  encoding = "LengthPrefixed" if args.length_prefixed else "Raw"
+
+  with filename.open("w", newline="") as o:
+    writer = csv.writer(o, dialect=csv.excel_tab)
+    writer.writerow(report_header)
+    for candidate in candidates:
+      writer.writerow([
+          f"0x{candidate.text_id:04X}",
+          len(candidate.text),
+          candidate.compressed_bytes,
+          candidate.draws,
+          encoding if candidate.picked else "Huffman",
+          candidate.bytes,
+          candidate.cycles_saved,
+        ])
+
+
+def main():
+  """Pick text entries to store uncompressed."""
+  parser = ArgumentParser(
+      description=desc,
+      formatter_class=RawTextHelpFormatter
+    )
+  parser.add_argument(
+      "rom",
+      type=Path,
+      help="The ROM to read text from."
+    )
+  parser.add_argument(
+      "output",
+      type=Path,
+      help="The installer file to write."
+    )
+  parser.add_argument(
+      "--budget",
+      type=lambda s: int(s, 0),
+      required=True,
+      help="The number of bytes of ROM to spend on uncompressed text."
+    )
+  parser.add_argument(
+      "--profile",
+      type=Path,
+      help="A table of how many times each text ID is drawn."
+    )
+  parser.add_argument(
+      "--length-prefixed",
+      action="store_true",
+      help="Write length-prefixed entries."
+    )
+  parser.add_argument(
+      "--report",
+      type=Path,
+      help="Save the estimate for each entry to a file."
+    )
+  parser.add_argument(
+      "--huffman-cycles",
+      type=float,
+      default=DEFAULT_HUFFMAN_CYCLES,
+      help="Cycles per bit of compressed text."
+    )
+  parser.add_argument(
+      "--decode-cycles",
+      type=float,
+      default=DEFAULT_DECODE_CYCLES,
+      help="Cycles per draw of compressed text."
+    )
+  parser.add_argument(
+      "--raw-cycles",
+      type=float,
+      default=DEFAULT_RAW_CYCLES,
+      help="Cycles per byte of uncompressed text."
+    )
+  parser.add_argument(
+      "--prefixed-cycles",
+      type=float,
+      default=DEFAULT_PREFIXED_CYCLES,
+      help="Cycles per byte of length-prefixed text."
+    )
+  parser.add_argument(
+      "--padding-cycles",
+      type=float,
+      default=DEFAULT_PADDING_CYCLES,
+      help="Cycles per byte of the padding pass."
+    )
+  add_tree_arguments(parser)
+  add_text_table_arguments(parser)
+
+  args = parser.parse_args()
+
+  rom = read_rom(args.rom)
+  tree = HuffmanTree(rom, args.tree, args.root)
+  profile = read_profile(args.profile) if (args.profile is not None) else {}
+
+  table = read_text_table_offset(rom, args.text_table)
+  candidates = []
+
+  for text_id, pointer in read_text_table(rom, args.text_table, args.count):
+
+    if pointer & UNCOMPRESSED_FLAG:
+      continue
+
+    text, compressed_bytes = decode_reference(tree, rom, pointer)
+    text = remove_huffman_padding(text)
+
+    candidates.append(
+        Candidate(text_id, text, compressed_bytes, profile.get(text_id, 1))
+      )
+
+  estimate_costs(candidates, args)
+  used = pick_candidates(candidates, args.budget)
+
+  with args.output.open("w") as o:
+    o.write(installer_header + "".join([
+        format_entry(
+            table, candidate.text_id, candidate.text, args.length_prefixed
+          )
+        for candidate in candidates
+        if candidate.picked
+      ]))
+
+  report(candidates, used, args.budget, args.profile is not None)
+
+  if args.report is not None:
+    write_report(candidates, args, args.report)
+
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -9,6 +9,7 @@ naming the files according to their unicode codepoint.
 
 import sys
 import re
+from io import BytesIO
 from argparse import ArgumentParser
 from pathlib import Path
 from itertools import product
@@ -21,7 +22,8 @@ be given the codepoint specified by the 'starting_codepoint' parameter, and
 the image will be sliced left-to-right, top-to-bottom, assigning the sliced
 glyphs successive codepoints.
 
-Blank glyphs in the sheet are not included in the output.
+Blank glyphs in the sheet are not included in the output, and glyphs that
+already exist in the output folder with the same contents are not rewritten.
 
 Example usage:
 slice_glyphs.py "./ASCII.png" "./GLYPHS" 0x000000
@@ -55,6 +57,17 @@ def _int_from_hex(value):
   return int(match.group("value"), 16)
 
 
+def _save_glyph(glyph_im, filename):
+  """Save a glyph image if it differs from the existing file."""
+  data = BytesIO()
+  glyph_im.save(data, format="PNG")
+
+  if filename.exists() and (filename.read_bytes() == data.getvalue()):
+    return
+
+  filename.write_bytes(data.getvalue())
+
+
 def main():
   """Slice graphics."""
   try:
@@ -115,7 +128,10 @@ def main():
 
       glyph_im = glyph_im.crop((0, 0, 16 if (right > 8) else 8, 16))
 
-      glyph_im.save(args.output_folder.joinpath(f"{current:06X}.png"))
+      _save_glyph(
+          glyph_im,
+          args.output_folder.joinpath(f"{current:06X}.png")
+        )
 
     current += 1
 